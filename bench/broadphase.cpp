@@ -0,0 +1,116 @@
+// Times each broadphase through the same generated ticks: every entity moves
+// a little, the broadphase is rebuilt, then every entity queries its own AABB
+// the way collision checks do. Reports time per tick and fails unless all of
+// them find the same pairs.
+//
+// usage: kme-bench-broadphase [ticks] [entities]
+
+#include "../src/math.hpp"
+#include "../src/states/basegame/broadphase.hpp"
+#include "../src/states/basegame/entity.hpp"
+
+#include <SFML/System.hpp>
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdlib>
+
+using namespace kme;
+
+// a long level, a few screens high, in tiles
+static constexpr float level_width = 2000.f;
+static constexpr float level_height = 40.f;
+
+struct Scene {
+  EntityRegistry registry;
+  std::vector<Broadphase::Item> items;
+  std::vector<Vec2f> velocities;
+};
+
+static Scene makeScene(std::size_t entities) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> x(0.f, level_width);
+  std::uniform_real_distribution<float> y(0.f, level_height);
+  std::uniform_real_distribution<float> size(0.5f, 2.f);
+  std::uniform_real_distribution<float> speed(-0.2f, 0.2f);
+
+  Scene scene;
+  for (std::size_t i = 0; i < entities; ++i) {
+    scene.items.push_back(Broadphase::Item {
+      .entity = scene.registry.create(),
+      .aabb = Rect<float>(x(rng), y(rng), size(rng), size(rng))
+    });
+    scene.velocities.emplace_back(speed(rng), speed(rng));
+  }
+  return scene;
+}
+
+struct Result {
+  float tick_ms;
+  std::size_t pairs;
+};
+
+static Result run(Broadphase::Type type, std::size_t ticks, std::size_t entities) {
+  Scene scene = makeScene(entities);
+  std::unique_ptr<Broadphase> broadphase = Broadphase::create(type);
+  std::vector<Broadphase::Item> found;
+
+  Result result {.tick_ms = 0.f, .pairs = 0};
+  sf::Clock clock;
+  for (std::size_t tick = 0; tick < ticks; ++tick) {
+    for (std::size_t i = 0; i < scene.items.size(); ++i) {
+      Rect<float>& aabb = scene.items[i].aabb;
+      aabb.x += scene.velocities[i].x;
+      aabb.y += scene.velocities[i].y;
+      if (aabb.x < 0.f or aabb.x > level_width) {
+        scene.velocities[i].x = -scene.velocities[i].x;
+      }
+      if (aabb.y < 0.f or aabb.y > level_height) {
+        scene.velocities[i].y = -scene.velocities[i].y;
+      }
+    }
+
+    broadphase->rebuild(scene.items);
+    for (const auto& item : scene.items) {
+      broadphase->query(item.aabb, found);
+      result.pairs += found.size();
+    }
+  }
+  result.tick_ms = clock.getElapsedTime().asSeconds() * 1000.f / ticks;
+  return result;
+}
+
+int main(int argc, char** argv) {
+  std::size_t ticks = argc > 1 ? std::stoul(argv[1]) : 600;
+  std::size_t entities = argc > 2 ? std::stoul(argv[2]) : 1000;
+  if (ticks == 0) {
+    std::cerr << "usage: " << argv[0] << " [ticks] [entities]\n";
+    return EXIT_FAILURE;
+  }
+
+  const Broadphase::Type types[] = {
+    Broadphase::Type::BRUTE_FORCE, Broadphase::Type::GRID, Broadphase::Type::SWEEP_AND_PRUNE
+  };
+  const char* names[] = {"brute force", "grid", "sweep and prune"};
+
+  bool agree = true;
+  std::size_t expected = 0;
+  for (std::size_t i = 0; i < 3; ++i) {
+    Result result = run(types[i], ticks, entities);
+    std::cout << names[i] << ": " << result.tick_ms << " ms per tick, "
+              << result.pairs << " pairs found\n";
+    if (i == 0) {
+      expected = result.pairs;
+    }
+    agree = agree and result.pairs == expected;
+  }
+
+  std::cout << ticks << " ticks of " << entities << " entities, "
+            << (agree ? "all broadphases agree" : "broadphases DISAGREE") << "\n";
+  return agree ? EXIT_SUCCESS : EXIT_FAILURE;
+}
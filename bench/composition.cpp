@@ -0,0 +1,136 @@
+// Measures frame time for the same scene composed two ways: through the
+// render texture chain states used to draw into (scene and HUD textures,
+// copied into the state's framebuffer, then the window's, then blitted), and
+// straight into the window through its canvas view.
+//
+// usage: kme-bench-composition [frames] [sprites]
+
+#include "../src/engine.hpp"
+#include "../src/math.hpp"
+#include "../src/renderer.hpp"
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <cstddef>
+#include <cstdlib>
+
+using namespace kme;
+
+static constexpr unsigned int canvas_width = 480;
+static constexpr unsigned int canvas_height = 270;
+
+struct Scene {
+  sf::Texture texture;
+  std::size_t sprites;
+  SpriteBatch batch;
+};
+
+static void drawScene(sf::RenderTarget& target, Scene& scene, std::size_t frame) {
+  target.clear(sf::Color(92, 148, 252));
+  for (std::size_t i = 0; i < scene.sprites; ++i) {
+    const Vec2f pos((i * 37 + frame) % canvas_width, (i * 53) % canvas_height);
+    scene.batch.push(scene.texture, Rect<int>(i % 4 * 16, 0, 16, 16), pos);
+  }
+  scene.batch.draw(target);
+}
+
+static void drawHUD(sf::RenderTarget& target, Scene& scene) {
+  // a strip of glyph-sized quads along the top and bottom edges
+  for (std::size_t i = 0; i < canvas_width / 8; ++i) {
+    scene.batch.push(scene.texture, Rect<int>(0, 0, 8, 8), Vec2f(8.f * i, 8.f));
+    scene.batch.push(scene.texture, Rect<int>(8, 0, 8, 8), Vec2f(8.f * i, canvas_height - 16.f));
+  }
+  scene.batch.draw(target);
+}
+
+// the chain as it was: every frame passes through four render textures
+struct Chain {
+  sf::RenderTexture scene, hud, framebuffer, window_framebuffer;
+
+  bool create() {
+    return scene.create(canvas_width, canvas_height)
+       and hud.create(canvas_width, canvas_height)
+       and framebuffer.create(canvas_width, canvas_height)
+       and window_framebuffer.create(canvas_width, canvas_height);
+  }
+};
+
+static void drawChained(Window& window, Chain& chain, Scene& scene, std::size_t frame) {
+  drawScene(chain.scene, scene, frame);
+  chain.hud.clear(sf::Color(0, 0, 0, 0));
+  drawHUD(chain.hud, scene);
+
+  chain.scene.display();
+  chain.hud.display();
+  chain.framebuffer.draw(sf::Sprite(chain.scene.getTexture()));
+  chain.framebuffer.draw(sf::Sprite(chain.hud.getTexture()));
+  chain.framebuffer.display();
+  chain.window_framebuffer.draw(sf::Sprite(chain.framebuffer.getTexture()));
+
+  // the old Window::drawWindow, with the view its resize() used to set
+  const Vec2u size = window.getSize();
+  const std::size_t scale = std::clamp<std::size_t>(size.x / canvas_width, 1, size.y / canvas_height);
+  sf::View view(Rect<float>(0, 0, size.x, size.y));
+  view.setCenter(canvas_width / 2, canvas_height / 2);
+  view.zoom(1.f / scale);
+  window.setView(view);
+
+  window.clear();
+  chain.window_framebuffer.display();
+  window.draw(sf::Sprite(chain.window_framebuffer.getTexture()));
+  window.display();
+}
+
+static void drawDirect(Window& window, Scene& scene, std::size_t frame) {
+  window.clearWindow();
+  drawScene(window, scene, frame);
+  drawHUD(window, scene);
+  window.drawWindow();
+}
+
+template<typename F>
+static float run(std::size_t frames, F&& draw) {
+  sf::Clock clock;
+  for (std::size_t i = 0; i < frames; ++i) {
+    draw(i);
+  }
+  return clock.getElapsedTime().asSeconds() * 1000.f / frames;
+}
+
+int main(int argc, char** argv) {
+  std::size_t frames = argc > 1 ? std::stoul(argv[1]) : 2000;
+
+  Scene scene;
+  scene.sprites = argc > 2 ? std::stoul(argv[2]) : 200;
+  sf::Image image;
+  image.create(64, 16, sf::Color(200, 76, 12));
+  scene.texture.loadFromImage(image);
+
+  Window window(1440, 810, "kme-bench-composition");
+  window.setVerticalSyncEnabled(false);
+
+  Chain chain;
+  if (not chain.create()) {
+    std::cerr << "could not create render textures\n";
+    return EXIT_FAILURE;
+  }
+
+  // once untimed, so both start with their textures and buffers warm
+  drawChained(window, chain, scene, 0);
+  drawDirect(window, scene, 0);
+
+  float chained_ms = run(frames, [&](std::size_t i) {
+    drawChained(window, chain, scene, i);
+  });
+  float direct_ms = run(frames, [&](std::size_t i) {
+    drawDirect(window, scene, i);
+  });
+
+  std::cout << "chained: " << chained_ms << " ms/frame\n"
+            << "direct:  " << direct_ms << " ms/frame\n";
+  return EXIT_SUCCESS;
+}
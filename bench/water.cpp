@@ -0,0 +1,128 @@
+// Draws a screenful of water overlay the way Gameplay::drawWater used to, as
+// one sprite per tile and surface column, and through drawRepeated. Reports
+// draw calls and frame time for both, and fails unless they produce the same
+// pixels and the batched version takes two draw calls.
+//
+// usage: kme-bench-water [frames]
+
+#include "../src/math.hpp"
+#include "../src/renderer.hpp"
+
+#include <SFML/Graphics.hpp>
+
+#include <iostream>
+#include <string>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+using namespace kme;
+
+static constexpr unsigned int canvas_width = 480;
+static constexpr unsigned int canvas_height = 270;
+static constexpr int top_height = 6;
+
+// translucent and different at every pixel, so any misplaced texel shows
+static sf::Texture makeTexture(unsigned int width, unsigned int height) {
+  sf::Image image;
+  image.create(width, height);
+  for (unsigned int y = 0; y < height; ++y)
+  for (unsigned int x = 0; x < width; ++x) {
+    image.setPixel(x, y, sf::Color(x * 16, y * 16, (x + y) * 8, 96 + x + y));
+  }
+
+  sf::Texture texture;
+  texture.loadFromImage(image);
+  texture.setRepeated(true);
+  return texture;
+}
+
+struct Scene {
+  sf::Texture top = makeTexture(64, top_height);
+  sf::Texture body = makeTexture(16, 16);
+  // scrolled off the tile grid, like the camera usually is
+  Vec2f origin = Vec2f(-7.f, 3.f);
+  Vec2i cells = Vec2i(canvas_width / 16 + 1, (canvas_height - top_height) / 16 + 1);
+  sf::VertexArray vertices;
+};
+
+static void drawSprites(sf::RenderTarget& target, Scene& scene, int frame, RenderStats& stats) {
+  for (int x = 0; x < scene.cells.x; ++x) {
+    sf::Sprite sprite(scene.top, Rect<int>(frame % 4 * 16, 0, 16, top_height));
+    sprite.setPosition(scene.origin + Vec2f(16.f * x, 0.f));
+    target.draw(sprite);
+    stats.count(4, &scene.top);
+  }
+
+  // bottom row first, as the old loop went up from the camera's bottom edge
+  for (int y = 0; y < scene.cells.y; ++y)
+  for (int x = 0; x < scene.cells.x; ++x) {
+    sf::Sprite sprite(scene.body);
+    sprite.setPosition(scene.origin + Vec2f(16.f * x, top_height + 16.f * (scene.cells.y - 1 - y)));
+    target.draw(sprite);
+    stats.count(4, &scene.body);
+  }
+}
+
+static void drawBatched(sf::RenderTarget& target, Scene& scene, int frame, RenderStats& stats) {
+  drawRepeated(target, scene.top, Rect<int>(frame % 4 * 16, 0, 16, top_height),
+               scene.origin, Vec2i(scene.cells.x, 1), Vec2f(16.f, 0.f),
+               scene.vertices, &stats);
+  drawRepeated(target, scene.body, Rect<int>(0, 0, 16, 16),
+               scene.origin + Vec2f(0.f, top_height + 16.f * (scene.cells.y - 1)),
+               scene.cells, Vec2f(16.f, -16.f), scene.vertices, &stats);
+}
+
+struct Result {
+  RenderStats stats;
+  float frame_ms;
+  sf::Image image;
+};
+
+template<typename F>
+static Result run(sf::RenderTexture& canvas, Scene& scene, std::size_t frames, F&& draw) {
+  Result result;
+  sf::Clock clock;
+  for (std::size_t i = 0; i < frames; ++i) {
+    result.stats.reset();
+    canvas.clear(sf::Color(40, 80, 120));
+    draw(canvas, scene, i, result.stats);
+    canvas.display();
+  }
+  // reading the pixels back waits for the GPU to finish
+  result.image = canvas.getTexture().copyToImage();
+  result.frame_ms = clock.getElapsedTime().asSeconds() * 1000.f / frames;
+  return result;
+}
+
+static void report(const std::string& name, const Result& result) {
+  std::cout << name << ": " << result.stats.draw_calls << " draw calls, "
+            << result.stats.vertices << " vertices, "
+            << result.frame_ms << " ms/frame\n";
+}
+
+int main(int argc, char** argv) {
+  std::size_t frames = argc > 1 ? std::stoul(argv[1]) : 2000;
+
+  sf::RenderTexture canvas;
+  if (not canvas.create(canvas_width, canvas_height)) {
+    std::cerr << "could not create a render texture\n";
+    return EXIT_FAILURE;
+  }
+
+  Scene scene;
+  // both end on the same animation frame, so their last images compare
+  Result sprites = run(canvas, scene, frames, drawSprites);
+  Result batched = run(canvas, scene, frames, drawBatched);
+
+  report("sprites", sprites);
+  report("batched", batched);
+
+  const Vec2u size = sprites.image.getSize();
+  bool identical = std::memcmp(sprites.image.getPixelsPtr(), batched.image.getPixelsPtr(),
+                               size.x * size.y * 4) == 0;
+  std::cout << "pixels " << (identical ? "identical" : "DIFFER") << "\n";
+
+  return identical and batched.stats.draw_calls == 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,5 +1,6 @@
 #include "assetmanager.hpp"
 
+#include "math.hpp"
 #include "types.hpp"
 #include "util/file.hpp"
 
@@ -8,9 +9,11 @@
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "assets/missing_texture_png.h"
 
@@ -108,6 +111,87 @@ const sf::Texture& GFXAssets::getTile(std::string name) {
   return getTexture(name);
 }
 
+void GFXAssets::buildTileAtlas(const StringList& names) {
+  static constexpr unsigned padding = 1;
+  const unsigned page_size = std::min(sf::Texture::getMaximumSize(), 2048u);
+
+  struct Source {
+    std::string name;
+    sf::Image image;
+    sf::Vector2u size;
+  };
+
+  std::vector<Source> sources;
+  for (const auto& name : names) {
+    if (name.empty() or atlas_regions.find(name) != atlas_regions.end()) {
+      continue;
+    }
+    const sf::Texture& texture = getTile(name);
+    const sf::Vector2u size = texture.getSize();
+    if (&texture == &GFXAssets::missing or size.x == 0 or size.y == 0
+    or size.x + padding > page_size or size.y + padding > page_size) {
+      continue;
+    }
+    sources.push_back(Source {.name = name, .image = texture.copyToImage(), .size = size});
+  }
+
+  // shelf packing, tallest first
+  std::sort(sources.begin(), sources.end(), [](const Source& lhs, const Source& rhs) {
+    return lhs.size.y != rhs.size.y ? lhs.size.y > rhs.size.y : lhs.name < rhs.name;
+  });
+
+  std::vector<std::pair<const Source*, sf::Vector2u>> placed;
+  unsigned x = 0, y = 0, shelf = 0;
+
+  auto flush = [&] {
+    if (placed.empty()) {
+      return;
+    }
+
+    sf::Image image;
+    image.create(page_size, std::min(y + shelf, page_size), sf::Color::Transparent);
+    for (const auto& item : placed) {
+      image.copy(item.first->image, item.second.x, item.second.y);
+    }
+
+    std::string page = "atlas:" + std::to_string(atlas_pages++);
+    sf::Texture texture;
+    texture.loadFromImage(image);
+    assets["tiles"][page] = std::move(texture);
+
+    for (const auto& item : placed) {
+      atlas_regions[item.first->name] = AtlasRegion {
+        .page = page,
+        .offset = Vec2i(item.second.x, item.second.y),
+        .size = Vec2i(item.first->size.x, item.first->size.y)
+      };
+    }
+
+    placed.clear();
+    x = y = shelf = 0;
+  };
+
+  for (const auto& source : sources) {
+    if (x + source.size.x > page_size) {
+      x = 0;
+      y += shelf;
+      shelf = 0;
+    }
+    if (y + source.size.y > page_size) {
+      flush();
+    }
+    placed.emplace_back(&source, sf::Vector2u(x, y));
+    x += source.size.x + padding;
+    shelf = std::max(shelf, source.size.y + padding);
+  }
+  flush();
+}
+
+const GFXAssets::AtlasRegion* GFXAssets::getAtlasRegion(const std::string& name) const {
+  auto iter = atlas_regions.find(name);
+  return iter != atlas_regions.end() ? &iter->second : nullptr;
+}
+
 const sf::Texture& GFXAssets::getSprite(std::string name) {
   try {
     return assets["sprites"].at(name);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "math.hpp"
 #include "types.hpp"
 #include "util/file.hpp"
 
@@ -12,6 +13,8 @@
 #include <string>
 
 namespace kme {
+using namespace vec2_aliases;
+
 class AssetManager {
 protected:
   AssetManager(const StringList& extensions);
@@ -33,6 +36,13 @@ public:
 
 class GFXAssets : public AssetManager {
 public:
+  // where buildTileAtlas put a texture
+  struct AtlasRegion {
+    std::string page;
+    Vec2i offset;
+    Vec2i size;
+  };
+
   static inline sf::Texture none;
   static inline sf::Texture missing;
 
@@ -46,6 +56,11 @@ public:
   bool loadTile(std::string name);
   bool loadTexture(std::string name);
 
+  // Packs the named tile textures into as few pages as the GPU allows, each
+  // registered as a tile of its own. Textures too big for a page are skipped.
+  void buildTileAtlas(const StringList& names);
+  const AtlasRegion* getAtlasRegion(const std::string& name) const;
+
 private:
   GFXAssets();
   GFXAssets(const GFXAssets&) = delete;
@@ -54,6 +69,8 @@ private:
   bool onLoad(util::FileInputStream& ifs, std::string folder, std::string name) final;
 
   StringTable<StringTable<sf::Texture>> assets;
+  StringTable<AtlasRegion> atlas_regions;
+  std::size_t atlas_pages = 0;
 };
 
 class SFXAssets : public AssetManager {
@@ -27,34 +27,40 @@ TimeInfo::TimeInfo(float rate) : rate(rate), delta(1.f / rate) {}
 Window::Window() : Window(1440, 810) {}
 
 Window::Window(std::size_t width, std::size_t height, std::string title)
-: sf::RenderWindow(sf::VideoMode(width, height), title) {
-  framebuffer.emplace();
-  framebuffer->create(480, 270);
-
+: sf::RenderWindow(sf::VideoMode(width, height), title), canvas_size(480, 270) {
   setKeyRepeatEnabled(false);
+  resize(width, height);
 
   sf::VideoMode screen = sf::VideoMode::getDesktopMode();
   setPosition((Vec2i(screen.width, screen.height) - Vec2i(width, height)) / 2);
 }
 
-std::optional<sf::RenderTexture>& Window::getFramebuffer() {
-  return framebuffer;
+Vec2u Window::getCanvasSize() const {
+  return canvas_size;
 }
 
-void Window::drawWindow() {
+const sf::View& Window::getCanvasView() const {
+  return canvas_view;
+}
+
+void Window::clearWindow() {
   clear();
-  framebuffer->display();
-  draw(sf::Sprite(framebuffer->getTexture()));
+  setView(canvas_view);
+}
+
+void Window::drawWindow() {
   display();
 }
 
 void Window::resize(std::size_t width, std::size_t height) {
-  Vec2z size = static_cast<sf::Vector2<std::size_t>>(framebuffer->getSize());
+  Vec2z size = static_cast<Vec2z>(canvas_size);
   std::size_t scale = std::clamp<std::size_t>(width / size.x, 1, height / size.y);
-  sf::View view(Rect<float>(0, 0, width, height));
-  view.setCenter(size.x / 2, size.y / 2);
-  view.zoom(1.f / scale);
-  setView(view);
+  Vec2f viewport = Vec2f(size.x * scale / float(width), size.y * scale / float(height));
+  canvas_view = sf::View(Rect<float>(0, 0, size.x, size.y));
+  canvas_view.setViewport(Rect<float>(
+    (1.f - viewport.x) / 2.f, (1.f - viewport.y) / 2.f, viewport.x, viewport.y
+  ));
+  setView(canvas_view);
 }
 
 // Engine functions
@@ -100,6 +106,10 @@ TimeInfo Engine::getRenderTime() const {
   return renderinfo;
 }
 
+float Engine::getTickAlpha() const {
+  return tick_alpha;
+}
+
 void Engine::pushState(BaseState::Factory factory) {
   events.push_back(StateEvent(StateEventType::PUSH, factory));
 }
@@ -144,6 +154,9 @@ bool Engine::main() {
     }
 
     if (draw_next < time) {
+      // interpolate from the last tick by the time elapsed since it was due
+      Duration since_update = Clock::now() - (update_next - update_delta);
+      tick_alpha = std::clamp(since_update / update_delta, 0.f, 1.f);
       draw(renderinfo.delta);
       TimePoint time = Clock::now();
       draw_next += draw_delta;
@@ -226,6 +239,7 @@ void Engine::update(float delta) {
 
 void Engine::draw(float delta) {
   if (window) {
+    window->clearWindow();
     for (BaseState* state : states) {
       state->draw(delta);
     }
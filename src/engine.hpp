@@ -18,6 +18,8 @@
 #include <cstddef>
 
 namespace kme {
+using namespace vec2_aliases;
+
 using Clock = std::chrono::steady_clock;
 using Duration = std::chrono::duration<float>;
 using TimePoint = std::chrono::time_point<Clock, Duration>;
@@ -39,13 +41,18 @@ public:
   Window();
   Window(std::size_t width, std::size_t height, std::string title = "Klaymore Engine");
 
+  // States draw straight into the window through the canvas view, which maps
+  // canvas coordinates onto the largest integer scale that fits the window.
+  void clearWindow();
   void drawWindow();
   void resize(std::size_t width, std::size_t height);
 
-  std::optional<sf::RenderTexture>& getFramebuffer();
+  Vec2u getCanvasSize() const;
+  const sf::View& getCanvasView() const;
 
 private:
-  std::optional<sf::RenderTexture> framebuffer;
+  Vec2u canvas_size;
+  sf::View canvas_view;
 };
 
 class Engine {
@@ -66,6 +73,8 @@ public:
   bool isRunning() const;
   TimeInfo getTickTime() const;
   TimeInfo getRenderTime() const;
+  // how far the current frame is between the last tick and the next, 0 to 1
+  float getTickAlpha() const;
 
   void pushState(BaseState::Factory factory);
   BaseState* popState();
@@ -89,6 +98,7 @@ private:
 
   TimeInfo tickinfo;
   TimeInfo renderinfo;
+  float tick_alpha = 1.f;
   PhysFSInfo physfsinfo;
 
   std::optional<Window> window;
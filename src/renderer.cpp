@@ -6,8 +6,15 @@
 
 #include <SFML/Graphics.hpp>
 
+#include <algorithm>
+#include <list>
+#include <map>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 
+#include <cmath>
 #include <cstddef>
 
 namespace kme {
@@ -20,25 +27,248 @@ TextStyle::TextStyle(std::string font_new, UInt32 flags_new) {
 
 TextStyle::TextStyle(std::string font_new) : TextStyle(font_new, Flags::NONE) {}
 
-void drawText(sf::RenderTarget& canvas, std::string text,
-              Vec2f origin, TextStyle style) {
-  const auto& texture = gfx.getTexture(style.font);
-  Vec2u texture_size = texture.getSize();
-  Vec2u view_size = canvas.getSize();
+// begin text
+static constexpr float glyph_size = 8.f;
+static constexpr std::size_t text_cache_max = 256;
+
+// Layouts only depend on the font and the text; alignment is applied when
+// they are placed. Lookups go through string views, so a hit allocates
+// nothing.
+struct TextKey {
+  std::string font;
+  std::string text;
+};
+
+struct TextKeyView {
+  std::string_view font;
+  std::string_view text;
+};
+
+struct TextKeyLess {
+  using is_transparent = void;
+
+  static TextKeyView view(const TextKey& key) { return TextKeyView {key.font, key.text}; }
+  static TextKeyView view(const TextKeyView& key) { return key; }
+
+  template<typename L, typename R>
+  bool operator ()(const L& lhs, const R& rhs) const {
+    const TextKeyView l = view(lhs);
+    const TextKeyView r = view(rhs);
+    return std::tie(l.font, l.text) < std::tie(r.font, r.text);
+  }
+};
+
+struct TextCacheEntry;
+using TextCache = std::map<TextKey, TextCacheEntry, TextKeyLess>;
+
+struct TextCacheEntry {
+  TextLayout layout;
+  // position in text_lru, least recently used first
+  std::list<TextCache::iterator>::iterator lru;
+};
+
+static TextCache text_cache;
+static std::list<TextCache::iterator> text_lru;
+
+static void layoutText(TextLayout& layout, std::string_view text) {
+  Vec2u texture_size = layout.texture->getSize();
   std::size_t length = text.length();
 
+  layout.size = Vec2f(glyph_size * length, glyph_size);
+  layout.vertices.setPrimitiveType(sf::Quads);
+  layout.vertices.resize(4 * length);
   for (std::size_t i = 0; i < length; ++i) {
     UByte c = text.at(i);
-    Rect<int> cliprect(c * 8 % texture_size.x, (c / 16) * 8 % texture_size.y, 8, 8);
-    sf::Sprite sprite(texture, cliprect);
-    bool align_right  = style.flags & TextStyle::Flags::ALIGN_RIGHT;
-    bool align_bottom = style.flags & TextStyle::Flags::ALIGN_BOTTOM;
-    Vec2f pos(
-      align_right ? view_size.x - 8 * length - origin.x : origin.x,
-      align_bottom ? view_size.y - 8 - origin.y : origin.y
+    Vec2f uv(c * 8 % texture_size.x, (c / 16) * 8 % texture_size.y);
+    Vec2f xy(glyph_size * i, 0.f);
+    layout.vertices[4 * i + 0] = sf::Vertex(xy, uv);
+    layout.vertices[4 * i + 1] = sf::Vertex(xy + Vec2f(8, 0), uv + Vec2f(8, 0));
+    layout.vertices[4 * i + 2] = sf::Vertex(xy + Vec2f(8, 8), uv + Vec2f(8, 8));
+    layout.vertices[4 * i + 3] = sf::Vertex(xy + Vec2f(0, 8), uv + Vec2f(0, 8));
+  }
+}
+
+const TextLayout& getTextLayout(std::string_view text, const TextStyle& style) {
+  auto iter = text_cache.find(TextKeyView {style.font, text});
+  if (iter != text_cache.end()) {
+    text_lru.splice(text_lru.end(), text_lru, iter->second.lru);
+    return iter->second.layout;
+  }
+
+  if (text_cache.size() >= text_cache_max) {
+    text_cache.erase(text_lru.front());
+    text_lru.pop_front();
+  }
+
+  iter = text_cache.emplace(TextKey {style.font, std::string(text)}, TextCacheEntry()).first;
+  iter->second.lru = text_lru.insert(text_lru.end(), iter);
+
+  TextLayout& layout = iter->second.layout;
+  layout.texture = &gfx.getTexture(style.font);
+  layoutText(layout, text);
+  return layout;
+}
+
+void clearTextCache() {
+  text_cache.clear();
+  text_lru.clear();
+}
+
+Vec2f measureText(std::string_view text, const TextStyle& style) {
+  return getTextLayout(text, style).size;
+}
+
+Vec2f alignText(Vec2u canvas_size, Vec2f size, Vec2f origin, const TextStyle& style) {
+  bool align_right  = style.flags & TextStyle::Flags::ALIGN_RIGHT;
+  bool align_bottom = style.flags & TextStyle::Flags::ALIGN_BOTTOM;
+  return Vec2f(
+    align_right ? canvas_size.x - size.x - origin.x : origin.x,
+    align_bottom ? canvas_size.y - size.y - origin.y : origin.y
+  );
+}
+
+void compileText(sf::VertexArray& vertices, Vec2u canvas_size, std::string_view text,
+                 Vec2f origin, const TextStyle& style) {
+  const TextLayout& layout = getTextLayout(text, style);
+  const Vec2f pos = alignText(canvas_size, layout.size, origin, style);
+
+  vertices.setPrimitiveType(sf::Quads);
+  for (std::size_t i = 0; i < layout.vertices.getVertexCount(); ++i) {
+    sf::Vertex vertex = layout.vertices[i];
+    vertex.position = Vec2f(vertex.position) + pos;
+    vertices.append(vertex);
+  }
+}
+
+void drawText(sf::RenderTarget& canvas, std::string_view text,
+              Vec2f origin, const TextStyle& style) {
+  const TextLayout& layout = getTextLayout(text, style);
+  const Vec2f pos = alignText(canvas.getSize(), layout.size, origin, style);
+
+  sf::RenderStates states(layout.texture);
+  states.transform.translate(pos);
+  canvas.draw(layout.vertices, states);
+}
+// end text
+
+// begin RenderStats
+void RenderStats::count(std::size_t vertex_count, const sf::Texture* texture_new) {
+  ++draw_calls;
+  vertices += vertex_count;
+  if (texture_new != texture) {
+    ++texture_binds;
+    texture = texture_new;
+  }
+}
+
+void RenderStats::reset() {
+  *this = RenderStats();
+}
+// end RenderStats
+
+// begin SpriteBatch
+void SpriteBatch::push(const sf::Texture& texture, Rect<int> cliprect,
+                       Vec2f pos, Vec2f scale, int layer) {
+  Quad& quad = quads.emplace_back();
+  quad.layer = layer;
+  quad.texture = &texture;
+  quad.order = quads.size() - 1;
+
+  const Vec2f size(cliprect.width, cliprect.height);
+  const Vec2f corners[4] = {
+    Vec2f(0.f, 0.f), Vec2f(size.x, 0.f), Vec2f(size.x, size.y), Vec2f(0.f, size.y)
+  };
+  for (std::size_t i = 0; i < 4; ++i) {
+    const Vec2f corner = corners[i];
+    quad.vertices[i] = sf::Vertex(
+      Vec2f(pos.x + scale.x * corner.x, pos.y + scale.y * corner.y),
+      Vec2f(cliprect.x + corner.x, cliprect.y + corner.y)
+    );
+  }
+}
+
+void SpriteBatch::draw(sf::RenderTarget& target, RenderStats* stats) {
+  std::sort(quads.begin(), quads.end(), [](const Quad& lhs, const Quad& rhs) {
+    return std::tie(lhs.layer, lhs.order) < std::tie(rhs.layer, rhs.order);
+  });
+
+  vertices.setPrimitiveType(sf::Quads);
+  for (std::size_t begin = 0; begin < quads.size();) {
+    std::size_t end = begin;
+    vertices.clear();
+    while (end < quads.size()
+    and quads[end].layer == quads[begin].layer
+    and quads[end].texture == quads[begin].texture) {
+      for (const auto& vertex : quads[end].vertices) {
+        vertices.append(vertex);
+      }
+      ++end;
+    }
+    target.draw(vertices, sf::RenderStates(quads[begin].texture));
+    if (stats != nullptr) {
+      stats->count(vertices.getVertexCount(), quads[begin].texture);
+    }
+    begin = end;
+  }
+
+  clear();
+}
+
+void SpriteBatch::clear() {
+  quads.clear();
+}
+
+std::size_t SpriteBatch::size() const {
+  return quads.size();
+}
+// end SpriteBatch
+
+// begin drawRepeated
+static void appendQuad(sf::VertexArray& vertices, Vec2f pos, Vec2f size, Vec2f uv) {
+  vertices.append(sf::Vertex(pos, uv));
+  vertices.append(sf::Vertex(Vec2f(pos.x + size.x, pos.y), Vec2f(uv.x + size.x, uv.y)));
+  vertices.append(sf::Vertex(pos + size, uv + size));
+  vertices.append(sf::Vertex(Vec2f(pos.x, pos.y + size.y), Vec2f(uv.x, uv.y + size.y)));
+}
+
+void drawRepeated(sf::RenderTarget& target, const sf::Texture& texture, Rect<int> cliprect,
+                  Vec2f pos, Vec2i count, Vec2f step,
+                  sf::VertexArray& vertices, RenderStats* stats) {
+  if (count.x <= 0 or count.y <= 0) {
+    return;
+  }
+
+  const Vec2u texture_size = texture.getSize();
+  const Vec2f clip_pos(cliprect.x, cliprect.y);
+  const Vec2f clip_size(cliprect.width, cliprect.height);
+  const bool seamless = texture.isRepeated()
+  and cliprect.x == 0 and cliprect.y == 0
+  and cliprect.width == int(texture_size.x) and cliprect.height == int(texture_size.y)
+  and std::abs(step.x) == clip_size.x
+  and (count.y == 1 or std::abs(step.y) == clip_size.y);
+
+  vertices.clear();
+  vertices.setPrimitiveType(sf::Quads);
+  if (seamless) {
+    // the texture repeats from the cell nearest the origin, so the cells
+    // line up with its period
+    const Vec2f begin(
+      pos.x + std::min(0.f, (count.x - 1) * step.x),
+      pos.y + std::min(0.f, (count.y - 1) * step.y)
     );
-    sprite.setPosition(pos.x + 8 * i, pos.y);
-    canvas.draw(sprite);
+    appendQuad(vertices, begin, Vec2f(count.x * clip_size.x, count.y * clip_size.y), Vec2f(0.f, 0.f));
+  }
+  else {
+    for (int j = 0; j < count.y; ++j)
+    for (int i = 0; i < count.x; ++i) {
+      appendQuad(vertices, Vec2f(pos.x + i * step.x, pos.y + j * step.y), clip_size, clip_pos);
+    }
+  }
+
+  target.draw(vertices, sf::RenderStates(&texture));
+  if (stats != nullptr) {
+    stats->count(vertices.getVertexCount(), &texture);
   }
 }
+// end drawRepeated
 }
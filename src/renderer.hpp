@@ -6,6 +6,10 @@
 #include <SFML/Graphics.hpp>
 
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
 
 namespace kme {
 using namespace vec2_aliases;
@@ -27,6 +31,80 @@ public:
   std::string font;
 };
 
-void drawText(sf::RenderTarget& canvas, std::string text,
-              Vec2f origin, TextStyle style);
+// Glyph quads of a string laid out from (0, 0), along with its size
+struct TextLayout {
+  Vec2f size;
+  sf::VertexArray vertices;
+  const sf::Texture* texture = nullptr;
+};
+
+// Compiled layouts are cached by font and string, evicting the least recently
+// used. The reference is valid until clearTextCache() or until enough other
+// layouts have been looked up to evict it.
+const TextLayout& getTextLayout(std::string_view text, const TextStyle& style);
+void clearTextCache();
+
+// size of the layout drawText would draw, so it goes through the same cache
+Vec2f measureText(std::string_view text, const TextStyle& style);
+
+// top left corner of a string of the given size once aligned on the canvas
+Vec2f alignText(Vec2u canvas_size, Vec2f size, Vec2f origin, const TextStyle& style);
+
+// appends the glyph quads drawText would draw on a canvas of the given size
+void compileText(sf::VertexArray& vertices, Vec2u canvas_size, std::string_view text,
+                 Vec2f origin, const TextStyle& style);
+
+void drawText(sf::RenderTarget& canvas, std::string_view text,
+              Vec2f origin, const TextStyle& style);
+
+// Counters for one frame of drawing
+struct RenderStats {
+  std::size_t draw_calls = 0;
+  std::size_t vertices = 0;
+  std::size_t texture_binds = 0;
+  std::size_t sprites_drawn = 0;
+  std::size_t sprites_culled = 0;
+  // texture of the last draw call, binds being counted on changes
+  const sf::Texture* texture = nullptr;
+
+  void count(std::size_t vertex_count, const sf::Texture* texture);
+  void reset();
+};
+
+// Collects textured quads over a frame and draws them with one vertex array
+// per run of consecutive quads sharing a layer and texture. Layers are drawn
+// in ascending order; within a layer, quads keep the order they were pushed
+// in, so callers get fewer draw calls by pushing same-texture quads together.
+class SpriteBatch {
+public:
+  // same placement as an sf::Sprite with the given position and scale
+  void push(const sf::Texture& texture, Rect<int> cliprect,
+            Vec2f pos, Vec2f scale = Vec2f(1.f, 1.f), int layer = 0);
+
+  // draws everything pushed since the last call and empties the batch
+  void draw(sf::RenderTarget& target, RenderStats* stats = nullptr);
+  void clear();
+
+  std::size_t size() const;
+
+private:
+  struct Quad {
+    int layer;
+    const sf::Texture* texture;
+    std::size_t order;
+    sf::Vertex vertices[4];
+  };
+
+  std::vector<Quad> quads;
+  sf::VertexArray vertices;
+};
+
+// Draws cliprect of texture at count.x by count.y cells, cell (i, j) being
+// placed at pos + (i * step.x, j * step.y), in one draw call and with the same
+// pixels as an sf::Sprite drawn per cell in row-major order. A cliprect that
+// covers all of a repeated texture and exactly fills each step becomes a
+// single quad; anything else gets a quad per cell.
+void drawRepeated(sf::RenderTarget& target, const sf::Texture& texture, Rect<int> cliprect,
+                  Vec2f pos, Vec2i count, Vec2f step,
+                  sf::VertexArray& vertices, RenderStats* stats = nullptr);
 }
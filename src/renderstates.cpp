@@ -1,5 +1,7 @@
 #include "renderstates.hpp"
 
+#include <utility>
+
 #include <cmath>
 
 namespace kme {
@@ -24,13 +26,11 @@ std::size_t RenderFrames::getFrameCount() const {
 }
 
 std::size_t RenderFrames::getFrameOffset(float time) const {
-  float time_max = 0.f;
-
-  for (const auto& frame : frames) {
-    time_max += frame.duration;
+  if (frames.size() <= 1 or duration <= 0.f) {
+    return 0;
   }
 
-  float time_mod = std::fmod(time, time_max);
+  float time_mod = std::fmod(time, duration);
   float accumulator = 0.f;
   std::size_t counter = 0;
 
@@ -44,6 +44,16 @@ std::size_t RenderFrames::getFrameOffset(float time) const {
 const RenderFrame& RenderFrames::getFrame(std::size_t offset) const {
   return frames.at(offset);
 }
+
+void RenderFrames::setFrame(std::size_t offset, RenderFrame frame) {
+  RenderFrame& target = frames.at(offset);
+  duration += frame.duration - target.duration;
+  target = std::move(frame);
+}
+
+float RenderFrames::getDuration() const {
+  return duration;
+}
 // end RenderFrames
 
 // begin RenderState
@@ -54,16 +64,16 @@ RenderState::RenderState(std::string label_arg) {
   offset = 0;
 }
 
-void RenderState::setState(std::string label_arg, std::size_t offset_arg) {
+void RenderState::setState(const std::string& label_arg, std::size_t offset_arg) {
   label = label_arg;
   offset = offset_arg;
 }
 
-void RenderState::setState(std::string label_arg) {
+void RenderState::setState(const std::string& label_arg) {
   setState(label_arg, 0);
 }
 
-std::string RenderState::getLabel() const {
+const std::string& RenderState::getLabel() const {
   return label;
 }
 
@@ -105,11 +115,11 @@ StringList RenderStates::getStateList() const {
   return state_list;
 }
 
-std::size_t RenderStates::getFrameCount(std::string label) const {
+std::size_t RenderStates::getFrameCount(const std::string& label) const {
   return states.at(label).getFrameCount();
 }
 
-std::size_t RenderStates::getFrameOffset(std::string label, float time) const {
+std::size_t RenderStates::getFrameOffset(const std::string& label, float time) const {
   return states.at(label).getFrameOffset(time);
 }
 
@@ -117,7 +127,7 @@ const RenderFrame& RenderStates::getFrame(const RenderState& label) const {
   return getFrame(label.getLabel(), label.getOffset());
 }
 
-const RenderFrame& RenderStates::getFrame(std::string label, std::size_t offset) const {
+const RenderFrame& RenderStates::getFrame(const std::string& label, std::size_t offset) const {
   return states.at(label).getFrame(offset);
 }
 // end RenderStates
@@ -26,6 +26,7 @@ public:
   std::size_t getFrameOffset(float time) const;
 
   const RenderFrame& getFrame(std::size_t offset) const;
+  void setFrame(std::size_t offset, RenderFrame frame);
   float getDuration() const;
 
 private:
@@ -38,10 +39,12 @@ public:
   RenderState();
   RenderState(std::string label);
 
-  void setState(std::string label);
-  void setState(std::string label, std::size_t offset);
+  // labels are copied into place, so setting one no longer than any set
+  // before does not allocate
+  void setState(const std::string& label);
+  void setState(const std::string& label, std::size_t offset);
 
-  std::string getLabel() const;
+  const std::string& getLabel() const;
   std::size_t getOffset() const;
 
 private:
@@ -61,11 +64,11 @@ public:
 
   StringList getStateList() const;
 
-  std::size_t getFrameCount(std::string state_arg) const;
-  std::size_t getFrameOffset(std::string label, float time) const;
+  std::size_t getFrameCount(const std::string& label) const;
+  std::size_t getFrameOffset(const std::string& label, float time) const;
 
   const RenderFrame& getFrame(const RenderState& label) const;
-  const RenderFrame& getFrame(std::string label, std::size_t offset) const;
+  const RenderFrame& getFrame(const std::string& label, std::size_t offset) const;
 
 private:
   StringTable<RenderFrames> states;
@@ -1,5 +1,6 @@
 #include "basegame.hpp"
 
+#include "../assetmanager.hpp"
 #include "../engine.hpp"
 #include "../graphics.hpp"
 #include "../math.hpp"
@@ -10,6 +11,7 @@
 #include "basegame/theme.hpp"
 #include "worldmap.hpp"
 
+#include <algorithm>
 #include <map>
 #include <sstream>
 #include <utility>
@@ -25,6 +27,36 @@ BaseGame::Factory BaseGame::create() {
 
 BaseGame::BaseGame(BaseState* parent, Engine* engine) : BaseState(parent, engine) {}
 
+// packs every tile graphic into the tile atlas and points the tiledefs at it,
+// so that whole tile layers draw from a handful of textures
+static void packTileAtlas(TileDefs& tiledefs) {
+  StringList textures;
+  for (const auto& tiledef : tiledefs) {
+    for (std::size_t i = 0; i < tiledef.getFrameCount(); ++i) {
+      textures.push_back(tiledef.getFrame(i).texture);
+    }
+  }
+  std::sort(textures.begin(), textures.end());
+  textures.erase(std::unique(textures.begin(), textures.end()), textures.end());
+
+  gfx.buildTileAtlas(textures);
+
+  for (auto& tiledef : tiledefs) {
+    for (std::size_t i = 0; i < tiledef.getFrameCount(); ++i) {
+      RenderFrame frame = tiledef.getFrame(i);
+      const auto* region = gfx.getAtlasRegion(frame.texture);
+      const Rect<int>& clip = frame.cliprect;
+      if (region == nullptr or clip.x < 0 or clip.y < 0
+      or clip.x + clip.width > region->size.x or clip.y + clip.height > region->size.y) {
+        continue; // relies on texture wrapping, leave it alone
+      }
+      frame.texture = region->page;
+      frame.cliprect = Rect<int>(clip.pos + region->offset, clip.size);
+      tiledef.setFrame(i, std::move(frame));
+    }
+  }
+}
+
 BaseGame::Spawner BaseGame::getSpawner(EntityRegistry& entities, EntityType entity_type) {
   return [this, &entities, entity_type](Vec2f pos) -> Entity {
     auto entity = entities.create();
@@ -38,6 +70,7 @@ BaseGame::Spawner BaseGame::getSpawner(EntityRegistry& entities, EntityType enti
 void BaseGame::enter() {
   TileDefLoader loader;
   loader.load(level_tile_data);
+  packTileAtlas(level_tile_data);
 
   entity_spawn_data["Player"] = [this](EntityRegistry& entities, Entity entity) {
     EntityType type = "Player";
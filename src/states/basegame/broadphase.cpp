@@ -0,0 +1,220 @@
+#include "broadphase.hpp"
+
+#include "../../math.hpp"
+#include "../../types.hpp"
+#include "entity.hpp"
+#include "spatialgrid.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+namespace kme {
+// begin EntityIndices
+void EntityIndices::clear() {
+  std::fill(table.begin(), table.end(), std::pair(Entity(entt::null), none));
+}
+
+void EntityIndices::set(Entity entity, std::size_t index) {
+  const std::size_t number = entt::to_entity(entity);
+  if (number >= table.size()) {
+    table.resize(number + 1, std::pair(Entity(entt::null), none));
+  }
+  table[number] = std::pair(entity, index);
+}
+
+std::size_t EntityIndices::find(Entity entity) const {
+  const std::size_t number = entt::to_entity(entity);
+  if (number < table.size() and table[number].first == entity) {
+    return table[number].second;
+  }
+  return none;
+}
+// end EntityIndices
+
+// begin Broadphase
+const StringTable<Broadphase::Type> Broadphase::type_table = {
+  {"brute_force", Type::BRUTE_FORCE},
+  {"grid", Type::GRID},
+  {"sweep_and_prune", Type::SWEEP_AND_PRUNE}
+};
+
+std::unique_ptr<Broadphase> Broadphase::create(Type type) {
+  switch (type) {
+  case Type::BRUTE_FORCE:
+    return std::make_unique<BruteForceBroadphase>();
+  case Type::GRID:
+    return std::make_unique<SpatialGrid>();
+  case Type::SWEEP_AND_PRUNE:
+    return std::make_unique<SweepAndPrune>();
+  }
+  return nullptr;
+}
+
+void Broadphase::rebuild(const std::vector<Item>& items) {
+  clear();
+  for (const auto& item : items) {
+    insert(item.entity, item.aabb);
+  }
+}
+// end Broadphase
+
+// begin BruteForceBroadphase
+Broadphase::Type BruteForceBroadphase::getType() const {
+  return Type::BRUTE_FORCE;
+}
+
+void BruteForceBroadphase::clear() {
+  items.clear();
+  indices.clear();
+}
+
+void BruteForceBroadphase::insert(Entity entity, Rect<float> aabb) {
+  indices.set(entity, items.size());
+  items.push_back(Item {.entity = entity, .aabb = aabb});
+}
+
+void BruteForceBroadphase::update(Entity entity, Rect<float> aabb) {
+  items[indices.find(entity)].aabb = aabb;
+}
+
+bool BruteForceBroadphase::contains(Entity entity) const {
+  return indices.find(entity) != EntityIndices::none;
+}
+
+void BruteForceBroadphase::query(Rect<float> region, std::vector<Item>& result) const {
+  result.clear();
+  for (const auto& item : items) {
+    if (geo::intersects(item.aabb, region)) {
+      result.push_back(item);
+    }
+  }
+}
+
+std::size_t BruteForceBroadphase::size() const {
+  return items.size();
+}
+// end BruteForceBroadphase
+
+// begin SweepAndPrune
+Broadphase::Type SweepAndPrune::getType() const {
+  return Type::SWEEP_AND_PRUNE;
+}
+
+void SweepAndPrune::clear() {
+  entries.clear();
+  indices.clear();
+  max_width = 0.f;
+  next_order = 0;
+}
+
+void SweepAndPrune::swapEntries(std::size_t lhs, std::size_t rhs) {
+  std::swap(entries[lhs], entries[rhs]);
+  indices.set(entries[lhs].item.entity, lhs);
+  indices.set(entries[rhs].item.entity, rhs);
+}
+
+void SweepAndPrune::insert(Entity entity, Rect<float> aabb) {
+  entries.push_back(Entry {.item = Item {.entity = entity, .aabb = aabb}, .order = next_order++});
+  indices.set(entity, entries.size() - 1);
+  max_width = std::max(max_width, aabb.width);
+
+  for (std::size_t i = entries.size() - 1; i > 0 and entries[i - 1].item.aabb.x > aabb.x; --i) {
+    swapEntries(i - 1, i);
+  }
+}
+
+void SweepAndPrune::rebuild(const std::vector<Item>& items) {
+  orders.clear();
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    orders.set(items[i].entity, i);
+  }
+
+  // keep the previous order of entities that are still around, so that the
+  // sort below only has to fix up what moved since then
+  entries_new.clear();
+  for (const auto& entry : entries) {
+    const std::size_t order = orders.find(entry.item.entity);
+    if (order != EntityIndices::none) {
+      entries_new.push_back(Entry {.item = items[order], .order = order});
+      orders.set(entry.item.entity, EntityIndices::none);
+    }
+  }
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    if (orders.find(items[i].entity) != EntityIndices::none) {
+      entries_new.push_back(Entry {.item = items[i], .order = i});
+    }
+  }
+  std::swap(entries, entries_new);
+  next_order = items.size();
+
+  // insertion sort, as the entries are nearly sorted already
+  for (std::size_t i = 1; i < entries.size(); ++i) {
+    Entry entry = entries[i];
+    std::size_t j = i;
+    for (; j > 0 and entries[j - 1].item.aabb.x > entry.item.aabb.x; --j) {
+      entries[j] = entries[j - 1];
+    }
+    entries[j] = entry;
+  }
+
+  indices.clear();
+  max_width = 0.f;
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    indices.set(entries[i].item.entity, i);
+    max_width = std::max(max_width, entries[i].item.aabb.width);
+  }
+}
+
+void SweepAndPrune::update(Entity entity, Rect<float> aabb) {
+  std::size_t i = indices.find(entity);
+  entries[i].item.aabb = aabb;
+  max_width = std::max(max_width, aabb.width);
+
+  for (; i > 0 and entries[i - 1].item.aabb.x > aabb.x; --i) {
+    swapEntries(i - 1, i);
+  }
+  for (; i + 1 < entries.size() and entries[i + 1].item.aabb.x < aabb.x; ++i) {
+    swapEntries(i, i + 1);
+  }
+}
+
+bool SweepAndPrune::contains(Entity entity) const {
+  return indices.find(entity) != EntityIndices::none;
+}
+
+void SweepAndPrune::query(Rect<float> region, std::vector<Item>& result) const {
+  result.clear();
+  found.clear();
+
+  // anything overlapping starts less than the widest item left of the region;
+  // the extra unit keeps rounding from dropping items at the boundary
+  const float begin_x = region.x - max_width - 1.f;
+  const float end_x = region.x + region.width;
+  auto begin = std::lower_bound(entries.begin(), entries.end(), begin_x,
+    [](const Entry& entry, float x) {
+      return entry.item.aabb.x < x;
+    }
+  );
+  for (auto iter = begin; iter != entries.end() and iter->item.aabb.x < end_x; ++iter) {
+    if (geo::intersects(iter->item.aabb, region)) {
+      found.push_back(&*iter);
+    }
+  }
+
+  std::sort(found.begin(), found.end(), [](const Entry* lhs, const Entry* rhs) {
+    return lhs->order < rhs->order;
+  });
+  for (const Entry* entry : found) {
+    result.push_back(entry->item);
+  }
+}
+
+std::size_t SweepAndPrune::size() const {
+  return entries.size();
+}
+// end SweepAndPrune
+}
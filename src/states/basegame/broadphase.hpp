@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../../math.hpp"
+#include "../../types.hpp"
+#include "entity.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+namespace kme {
+using namespace vec2_aliases;
+
+// Maps entities to indices through a table indexed by entity number, so it
+// never hashes and, once grown, refilling it allocates nothing
+class EntityIndices {
+public:
+  static constexpr std::size_t none = -1;
+
+  void clear();
+  void set(Entity entity, std::size_t index);
+  // none if the entity isn't mapped
+  std::size_t find(Entity entity) const;
+
+private:
+  std::vector<std::pair<Entity, std::size_t>> table;
+};
+
+// Finds the entities whose AABBs may overlap a region. Queries return every
+// item whose stored AABB intersects the region, in the order the items were
+// given to rebuild() or insert(), so all implementations agree exactly.
+class Broadphase {
+public:
+  enum class Type {
+    BRUTE_FORCE,
+    GRID,
+    SWEEP_AND_PRUNE
+  };
+
+  struct Item {
+    Entity entity;
+    Rect<float> aabb;
+  };
+
+  // names used by the "broadphase" property of level maps
+  static const StringTable<Type> type_table;
+
+  static std::unique_ptr<Broadphase> create(Type type);
+
+  virtual ~Broadphase() = default;
+
+  virtual Type getType() const = 0;
+
+  virtual void clear() = 0;
+  virtual void insert(Entity entity, Rect<float> aabb) = 0;
+  // replaces the contents with the given items
+  virtual void rebuild(const std::vector<Item>& items);
+  // moves an inserted entity; it keeps its place in the insertion order
+  virtual void update(Entity entity, Rect<float> aabb) = 0;
+  virtual bool contains(Entity entity) const = 0;
+
+  virtual void query(Rect<float> region, std::vector<Item>& result) const = 0;
+
+  virtual std::size_t size() const = 0;
+};
+
+// Tests every item against every query
+class BruteForceBroadphase final : public Broadphase {
+public:
+  Type getType() const final;
+
+  void clear() final;
+  void insert(Entity entity, Rect<float> aabb) final;
+  void update(Entity entity, Rect<float> aabb) final;
+  bool contains(Entity entity) const final;
+
+  void query(Rect<float> region, std::vector<Item>& result) const final;
+
+  std::size_t size() const final;
+
+private:
+  std::vector<Item> items;
+  EntityIndices indices;
+};
+
+// Keeps items sorted by the left edge of their AABBs, so a query only scans
+// the items whose left edges fall within the widest item of the region. The
+// order persists across rebuilds; since things scroll by little per tick, it
+// is restored by insertion sort in close to linear time.
+class SweepAndPrune final : public Broadphase {
+public:
+  Type getType() const final;
+
+  void clear() final;
+  void insert(Entity entity, Rect<float> aabb) final;
+  void rebuild(const std::vector<Item>& items) final;
+  void update(Entity entity, Rect<float> aabb) final;
+  bool contains(Entity entity) const final;
+
+  void query(Rect<float> region, std::vector<Item>& result) const final;
+
+  std::size_t size() const final;
+
+private:
+  struct Entry {
+    Item item;
+    std::size_t order;
+  };
+
+  void swapEntries(std::size_t lhs, std::size_t rhs);
+
+  std::vector<Entry> entries;
+  // index into entries for each entity
+  EntityIndices indices;
+  float max_width = 0.f;
+  std::size_t next_order = 0;
+
+  std::vector<Entry> entries_new;
+  EntityIndices orders;
+  mutable std::vector<const Entry*> found;
+};
+}
@@ -0,0 +1,176 @@
+#include "chunkstreamer.hpp"
+
+#include "../../math.hpp"
+#include "../../types.hpp"
+#include "levelfile.hpp"
+#include "tiledefs.hpp"
+#include "tilemap.hpp"
+
+#include <physfs.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cmath>
+
+namespace kme {
+ChunkStreamer::ChunkStreamer(std::string path, const LevelFile& level_file, std::size_t subworld,
+                             const TileDefs& tiledefs, std::size_t budget)
+: path(path), tiledefs(&tiledefs), types(level_file.types),
+  entries(level_file.types.size()), budget(budget) {
+  file = PHYSFS_openRead(path.c_str());
+  if (file == nullptr) {
+    throw std::runtime_error(path + ": " + PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+  }
+
+  for (const auto& layer : level_file.subworlds.at(subworld).layers) {
+    layers.push_back(Layer {
+      .index = layer.index,
+      .chunk_bounds = layer.chunk_bounds,
+      .chunk_offsets = layer.chunk_offsets
+    });
+  }
+}
+
+ChunkStreamer::~ChunkStreamer() {
+  if (file != nullptr) {
+    PHYSFS_close(file);
+  }
+}
+
+std::size_t ChunkStreamer::getBudget() const {
+  return budget;
+}
+
+void ChunkStreamer::setBudget(std::size_t budget_new) {
+  budget = budget_new;
+}
+
+std::size_t ChunkStreamer::getResidentCount() const {
+  return resident.size();
+}
+
+const ChunkStreamer::Layer* ChunkStreamer::findLayer(int index) const {
+  for (const auto& layer : layers) {
+    if (layer.index == index) {
+      return &layer;
+    }
+  }
+  return nullptr;
+}
+
+Tilemap::Chunk::Entry ChunkStreamer::getEntry(UInt16 type) {
+  auto& entry = entries[type];
+  if (not entry.has_value()) {
+    TileID tile_id = type == 0 ? Tilemap::notile : tiledefs->getTileID(types[type]);
+    entry = Tilemap::Chunk::Entry {
+      .tile = tile_id,
+      .collision = tiledefs->getTileDef(tile_id).getCollisionType()
+    };
+  }
+  return *entry;
+}
+
+Tilemap::Chunk ChunkStreamer::readChunk(const Layer& layer, Vec2s pos) {
+  const Rect<int>& chunk_bounds = layer.chunk_bounds;
+  std::size_t index = (pos.y - chunk_bounds.y) * chunk_bounds.width + (pos.x - chunk_bounds.x);
+
+  record.resize(LevelFile::chunk_record_max);
+  if (PHYSFS_seek(file, layer.chunk_offsets[index]) == 0) {
+    throw std::runtime_error(path + ": " + PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+  }
+  auto length = PHYSFS_readBytes(file, record.data(), record.size());
+  record.resize(std::max<PHYSFS_sint64>(length, 0));
+
+  UInt16 tiles[256];
+  LevelFile::decodeChunk(record, 0, types.size(), tiles);
+
+  Tilemap::Chunk chunk(getEntry(tiles[0]));
+  for (std::size_t i = 1; i < 256; ++i) {
+    if (tiles[i] != tiles[0]) {
+      for (std::size_t j = 0; j < 256; ++j) {
+        chunk.setEntry(j % 16, j / 16, getEntry(tiles[j]));
+      }
+      chunk.compact();
+      break;
+    }
+  }
+
+  return chunk;
+}
+
+void ChunkStreamer::update(Tilemap& tilemap, const std::vector<Rect<float>>& focus) {
+  for (const auto& change : tilemap.getJournal()) {
+    const Vec2i pos = change.tile.pos;
+    auto iter = resident.find(ChunkRef {
+      .layer = change.tile.layer, .pos = Tilemap::getChunkPos(pos.x, pos.y)
+    });
+    if (iter != resident.end()) {
+      iter->second = true;
+    }
+  }
+
+  // everything within a chunk of a focus is wanted
+  wanted.clear();
+  for (const auto& aabb : focus) {
+    const Vec2s begin = Tilemap::getChunkPos(std::floor(aabb.x) - 16, std::floor(aabb.y) - 16);
+    const Vec2s end = Tilemap::getChunkPos(
+      std::ceil(aabb.x + aabb.width) + 16, std::ceil(aabb.y + aabb.height) + 16
+    );
+    for (const auto& layer : layers) {
+      const Rect<int>& bounds = layer.chunk_bounds;
+      const int x_begin = std::max<int>(begin.x, bounds.x);
+      const int x_end = std::min<int>(end.x + 1, bounds.x + bounds.width);
+      const int y_begin = std::max<int>(begin.y, bounds.y);
+      const int y_end = std::min<int>(end.y + 1, bounds.y + bounds.height);
+      for (int y = y_begin; y < y_end; ++y)
+      for (int x = x_begin; x < x_end; ++x) {
+        wanted.push_back(ChunkRef {.layer = layer.index, .pos = Vec2s(x, y)});
+      }
+    }
+  }
+  std::sort(wanted.begin(), wanted.end());
+  wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+
+  for (const auto& ref : wanted) {
+    if (resident.find(ref) == resident.end()) {
+      tilemap.setChunk(ref.layer, ref.pos, readChunk(*findLayer(ref.layer), ref.pos));
+      resident[ref] = false;
+    }
+  }
+
+  if (resident.size() <= budget) {
+    return;
+  }
+
+  // evict unwanted, unmodified chunks, farthest from the camera first
+  const Vec2f center = focus.empty() ? Vec2f() : geo::midpoint(focus.front());
+  std::vector<std::pair<float, ChunkRef>> candidates;
+  for (const auto& iter : resident) {
+    const ChunkRef& ref = iter.first;
+    if (std::binary_search(wanted.begin(), wanted.end(), ref)) {
+      continue;
+    }
+    if (iter.second) {
+      continue;
+    }
+    const Vec2f chunk_center(ref.pos.x * 16 + 8, ref.pos.y * 16 + 8);
+    const Vec2f diff = chunk_center - center;
+    candidates.emplace_back(diff.x * diff.x + diff.y * diff.y, ref);
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.first > rhs.first;
+  });
+
+  for (const auto& candidate : candidates) {
+    if (resident.size() <= budget) {
+      break;
+    }
+    tilemap.resetChunk(candidate.second.layer, candidate.second.pos);
+    resident.erase(candidate.second);
+  }
+}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../../math.hpp"
+#include "../../types.hpp"
+#include "levelfile.hpp"
+#include "tiledefs.hpp"
+#include "tilemap.hpp"
+
+#include <physfs.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace kme {
+// Pages the chunks of one subworld of a compiled level in and out of its
+// Tilemap around a set of focus rectangles, in tile units. Chunks near a focus
+// are always resident; beyond that, at most `budget` chunks are kept and the
+// ones farthest from the first focus (the camera) are evicted first. Chunks
+// edited since they were paged in are never evicted; update finds them in the
+// tilemap's journal, so it has to run before every clearJournal().
+class ChunkStreamer {
+public:
+  ChunkStreamer(std::string path, const LevelFile& level_file, std::size_t subworld,
+                const TileDefs& tiledefs, std::size_t budget);
+  ~ChunkStreamer();
+
+  ChunkStreamer(const ChunkStreamer&) = delete;
+  ChunkStreamer& operator =(const ChunkStreamer&) = delete;
+
+  std::size_t getBudget() const;
+  void setBudget(std::size_t budget);
+
+  std::size_t getResidentCount() const;
+
+  void update(Tilemap& tilemap, const std::vector<Rect<float>>& focus);
+
+private:
+  struct Layer {
+    int index;
+    Rect<int> chunk_bounds;
+    std::vector<UInt32> chunk_offsets;
+  };
+
+  const Layer* findLayer(int index) const;
+  Tilemap::Chunk readChunk(const Layer& layer, Vec2s pos);
+  Tilemap::Chunk::Entry getEntry(UInt16 type);
+
+  std::string path;
+  PHYSFS_File* file = nullptr;
+
+  const TileDefs* tiledefs;
+  std::vector<std::string> types;
+  std::vector<std::optional<Tilemap::Chunk::Entry>> entries;
+  std::vector<Layer> layers;
+
+  std::size_t budget;
+  // every resident chunk, and whether it has been edited since paged in
+  std::map<ChunkRef, bool> resident;
+
+  std::vector<ChunkRef> wanted;
+  std::vector<char> record;
+};
+}
@@ -14,6 +14,7 @@ struct WorldCollision {
   Tile tile;
 
   bool operator ==(const WorldCollision& rhs) const;
+  bool operator <(const WorldCollision& rhs) const;
 };
 
 struct EntityCollision {
@@ -21,6 +22,7 @@ struct EntityCollision {
   Entity entity2;
 
   bool operator ==(const EntityCollision& rhs) const;
+  bool operator <(const EntityCollision& rhs) const;
 };
 
 struct CollisionEvent {
@@ -1,11 +1,22 @@
 #include "collision.hpp"
 
+#include <tuple>
+
 namespace kme {
 bool WorldCollision::operator ==(const WorldCollision& rhs) const {
   return entity == rhs.entity and tile == rhs.tile;
 }
 
+bool WorldCollision::operator <(const WorldCollision& rhs) const {
+  return std::tie(entity, tile.layer, tile.pos.y, tile.pos.x)
+       < std::tie(rhs.entity, rhs.tile.layer, rhs.tile.pos.y, rhs.tile.pos.x);
+}
+
 bool EntityCollision::operator ==(const EntityCollision& rhs) const {
   return entity1 == rhs.entity1 and entity2 == rhs.entity2;
 }
+
+bool EntityCollision::operator <(const EntityCollision& rhs) const {
+  return std::tie(entity1, entity2) < std::tie(rhs.entity1, rhs.entity2);
+}
 }
@@ -1,4 +1,3 @@
 #pragma once
 
 #include "collision-decl.hpp"
-#include "collision-impl.hpp"
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <cstddef>
+
+namespace kme {
+// A set of contacts kept in the order they were first added. The first N live
+// inline; the rest spill into a vector whose storage is kept across clear(),
+// so refilling the list each tick stops allocating once it has grown.
+template<typename T, std::size_t N>
+class ContactList {
+public:
+  using value_type = T;
+  using const_iterator = const T*;
+
+  // adds the contact unless it's already there, in which case returns false
+  bool insert(const T& value);
+  bool contains(const T& value) const;
+  void clear();
+
+  std::size_t size() const;
+  bool empty() const;
+
+  const T& operator [](std::size_t index) const;
+
+  // only valid until the next insert
+  const_iterator begin() const;
+  const_iterator end() const;
+
+private:
+  const T* data() const;
+
+  std::array<T, N> values;
+  std::size_t count = 0;
+  // every contact once the inline storage has overflowed
+  std::vector<T> spill;
+};
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "contactlist-decl.hpp"
+
+#include <algorithm>
+
+namespace kme {
+template<typename T, std::size_t N>
+bool ContactList<T, N>::insert(const T& value) {
+  if (contains(value)) {
+    return false;
+  }
+
+  if (count < N) {
+    values[count] = value;
+  }
+  else {
+    if (count == N) {
+      spill.assign(values.begin(), values.end());
+    }
+    spill.push_back(value);
+  }
+  ++count;
+  return true;
+}
+
+template<typename T, std::size_t N>
+bool ContactList<T, N>::contains(const T& value) const {
+  return std::find(begin(), end(), value) != end();
+}
+
+template<typename T, std::size_t N>
+void ContactList<T, N>::clear() {
+  count = 0;
+  spill.clear();
+}
+
+template<typename T, std::size_t N>
+std::size_t ContactList<T, N>::size() const {
+  return count;
+}
+
+template<typename T, std::size_t N>
+bool ContactList<T, N>::empty() const {
+  return count == 0;
+}
+
+template<typename T, std::size_t N>
+const T& ContactList<T, N>::operator [](std::size_t index) const {
+  return data()[index];
+}
+
+template<typename T, std::size_t N>
+const T* ContactList<T, N>::data() const {
+  return count > N ? spill.data() : values.data();
+}
+
+template<typename T, std::size_t N>
+typename ContactList<T, N>::const_iterator ContactList<T, N>::begin() const {
+  return data();
+}
+
+template<typename T, std::size_t N>
+typename ContactList<T, N>::const_iterator ContactList<T, N>::end() const {
+  return data() + count;
+}
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+#include "contactlist-decl.hpp"
+#include "contactlist-impl.hpp"
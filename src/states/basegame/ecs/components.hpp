@@ -7,6 +7,7 @@
 #include "../../../renderstates.hpp"
 #include "../../../sound.hpp"
 #include "../../../util.hpp"
+#include "../contactlist.hpp"
 #include "../hitbox.hpp"
 #include "../powerup.hpp"
 #include "../states.hpp"
@@ -14,8 +15,8 @@
 
 #include <entt/entt.hpp>
 
+#include <optional>
 #include <string>
-#include <unordered_set>
 
 #include <cstddef>
 
@@ -76,10 +77,14 @@ struct CState {
 };
 
 struct CCollision {
+  // the rest only holds state from the last tick, so it starts out empty
+  CCollision(Hitbox hitbox_new = Hitbox()) : hitbox(hitbox_new) {}
+
   Hitbox hitbox;
   Vec2f pos_old;
-  std::unordered_set<Tile> tiles;
-  std::unordered_set<Entity> entities;
+  // contacts this tick, in the order they were found
+  ContactList<Tile, 16> tiles;
+  ContactList<Entity, 8> entities;
 };
 
 struct CCounters {
@@ -98,6 +103,8 @@ struct CRender {
   RenderState state;
   float time = 0.f;
   Vec2f scale = Vec2f(1.f, 1.f);
+  // position at the start of the tick, unset until the entity's first tick
+  std::optional<Vec2f> pos_old;
 };
 
 struct CAudio {
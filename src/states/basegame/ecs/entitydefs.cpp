@@ -15,7 +15,7 @@ void EntityDefs::registerHitboxes(EntityType type, Hitboxes states) {
   hitboxes[type] = states;
 }
 
-const EntityDefs::Hitboxes& EntityDefs::getHitboxes(EntityType type) const {
+const EntityDefs::Hitboxes& EntityDefs::getHitboxes(const EntityType& type) const {
   return hitboxes.at(type);
 }
 
@@ -28,7 +28,7 @@ void EntityDefs::registerRenderStates(EntityType type, RenderStates rs) {
   render_states[type] = rs;
 }
 
-const RenderStates& EntityDefs::getRenderStates(EntityType type) const {
+const RenderStates& EntityDefs::getRenderStates(const EntityType& type) const {
   return render_states.at(type);
 }
 }
@@ -21,10 +21,10 @@ public:
   using Hitboxes = std::map<Powerup, std::map<EState, Hitbox>>;
 
   void registerHitboxes(EntityType type, Hitboxes states);
-  const Hitboxes& getHitboxes(EntityType type) const;
+  const Hitboxes& getHitboxes(const EntityType& type) const;
 
   void registerRenderStates(EntityType type, RenderStates rs);
-  const RenderStates& getRenderStates(EntityType type) const;
+  const RenderStates& getRenderStates(const EntityType& type) const;
 
 private:
   std::unordered_map<EntityType, Hitboxes> hitboxes;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include <cstddef>
+
+namespace kme {
+// Events gathered over one tick. Pushing appends to storage that is kept from
+// tick to tick and clear() just rewinds it. Duplicates are dropped by sorting,
+// so a deduplicated buffer always iterates in the same order.
+template<typename T>
+class EventBuffer {
+public:
+  using value_type = T;
+  using const_iterator = const T*;
+
+  void push(const T& event);
+  // sorts the events and drops duplicates; cheap if nothing was pushed since
+  void deduplicate();
+  void clear();
+
+  std::size_t size() const;
+  bool empty() const;
+
+  // only valid until the next push
+  const_iterator begin() const;
+  const_iterator end() const;
+
+private:
+  std::vector<T> events;
+  std::size_t count = 0;
+  bool deduplicated = true;
+};
+}
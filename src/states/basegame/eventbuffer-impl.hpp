@@ -0,0 +1,54 @@
+#pragma once
+
+#include "eventbuffer-decl.hpp"
+
+#include <algorithm>
+
+namespace kme {
+template<typename T>
+void EventBuffer<T>::push(const T& event) {
+  if (count < events.size()) {
+    events[count] = event;
+  }
+  else {
+    events.push_back(event);
+  }
+  ++count;
+  deduplicated = false;
+}
+
+template<typename T>
+void EventBuffer<T>::deduplicate() {
+  if (not deduplicated) {
+    std::sort(events.begin(), events.begin() + count);
+    count = std::unique(events.begin(), events.begin() + count) - events.begin();
+    deduplicated = true;
+  }
+}
+
+template<typename T>
+void EventBuffer<T>::clear() {
+  count = 0;
+  deduplicated = true;
+}
+
+template<typename T>
+std::size_t EventBuffer<T>::size() const {
+  return count;
+}
+
+template<typename T>
+bool EventBuffer<T>::empty() const {
+  return count == 0;
+}
+
+template<typename T>
+typename EventBuffer<T>::const_iterator EventBuffer<T>::begin() const {
+  return events.data();
+}
+
+template<typename T>
+typename EventBuffer<T>::const_iterator EventBuffer<T>::end() const {
+  return events.data() + count;
+}
+}
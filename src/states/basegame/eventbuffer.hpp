@@ -0,0 +1,4 @@
+#pragma once
+
+#include "eventbuffer-decl.hpp"
+#include "eventbuffer-impl.hpp"
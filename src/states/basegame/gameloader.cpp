@@ -8,6 +8,8 @@
 #include <json/reader.h>
 #include <json/value.h>
 
+#include <iostream>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -26,6 +28,54 @@ const StringTable<TileDef::CollisionType> TileDefLoader::collision_table = {
   {"lava", TileDef::CollisionType::LAVA}
 };
 
+const StringTable<UInt32> TileDefLoader::flag_table = {
+  {"slippery", TileDef::Flags::SLIPPERY},
+  {"coin", TileDef::Flags::COIN},
+  {"bumpable", TileDef::Flags::BUMPABLE},
+  {"breakable", TileDef::Flags::BREAKABLE},
+  {"bump_coin", TileDef::Flags::BUMP_COIN}
+};
+
+// Temporary: the flags and transforms tiles had when collision handling
+// still matched them by name, for tile definitions without a "flags" key.
+// Remove both tables once every tiledefs file lists its flags; until then
+// setMaterial warns the first time a tile falls back to them.
+static const StringTable<UInt32> legacy_flags = {
+  {"WoodFloorSnow_0", TileDef::Flags::SLIPPERY},
+  {"WoodFloorSnow_1", TileDef::Flags::SLIPPERY},
+  {"WoodFloorSnow_2", TileDef::Flags::SLIPPERY},
+  {"WoodFloorSnow_9", TileDef::Flags::SLIPPERY},
+  {"WoodFloorSnow_12", TileDef::Flags::SLIPPERY},
+  {"WoodFloorSnow_13", TileDef::Flags::SLIPPERY},
+  {"WoodFloorSnow_14", TileDef::Flags::SLIPPERY},
+  {"IceBlock", TileDef::Flags::SLIPPERY},
+  {"IceBlockCoin", TileDef::Flags::SLIPPERY},
+  {"IceBlockMuncher", TileDef::Flags::SLIPPERY},
+  {"IceBlockBig_0", TileDef::Flags::SLIPPERY},
+  {"IceBlockBig_1", TileDef::Flags::SLIPPERY},
+  {"IceBlockBig_2", TileDef::Flags::SLIPPERY},
+  {"IceBlockBig_3", TileDef::Flags::SLIPPERY},
+  {"CoinGold", TileDef::Flags::COIN},
+  {"BrickGold", TileDef::Flags::BUMPABLE | TileDef::Flags::BREAKABLE},
+  {"QuestionBlock", TileDef::Flags::BUMPABLE | TileDef::Flags::BUMP_COIN}
+};
+
+static const StringTable<TileType> legacy_transforms = {
+  {"QuestionBlock", "EmptyBlock"}
+};
+
+static std::optional<UInt32> parseFlags(const Json::Value& value) {
+  if (value.isNull()) {
+    return std::nullopt;
+  }
+
+  UInt32 flags = TileDef::Flags::NONE;
+  for (const auto& flag : value) {
+    flags |= TileDefLoader::flag_table.at(flag.asString());
+  }
+  return flags;
+}
+
 TileDefLoader::TileDefLoader(std::string filename) {
   Json::Value root;
   Json::Reader reader;
@@ -34,6 +84,10 @@ TileDefLoader::TileDefLoader(std::string filename) {
       TileDefLoader loader(val.asString());
       for (auto iter : loader.tile_data) {
         tile_data[iter.first] = iter.second;
+        transform_types.erase(iter.first);
+      }
+      for (auto iter : loader.transform_types) {
+        transform_types[iter.first] = iter.second;
       }
     }
 
@@ -43,6 +97,8 @@ TileDefLoader::TileDefLoader(std::string filename) {
       TileDef::CollisionType collision = tile["collision"].isNull() \
       ? TileDef::CollisionType::NONE
       : collision_table.at(tile["collision"].asString());
+      std::optional<UInt32> flags = parseFlags(tile["flags"]);
+      TileType transforms_to = tile["transforms_to"].asString();
 
       if (type == "indexed") {
         std::size_t offset = tile["firstindex"].asUInt();
@@ -58,6 +114,13 @@ TileDefLoader::TileDefLoader(std::string filename) {
 
           tile_data[ss.str()].pushFrame(texture, origin, 0.f);
           tile_data[ss.str()].setCollisionType(collision);
+
+          // frames may add flags on top of the ones shared by the whole set
+          std::optional<UInt32> frame_flags = parseFlags(frame["flags"]);
+          if (frame_flags.has_value()) {
+            *frame_flags |= flags.value_or(TileDef::Flags::NONE);
+          }
+          setMaterial(ss.str(), frame_flags.has_value() ? frame_flags : flags, transforms_to);
         }
       }
       else if (type == "animated") {
@@ -67,6 +130,7 @@ TileDefLoader::TileDefLoader(std::string filename) {
           tile_data[name].pushFrame(texture, origin, 8.f / 60.f);
           tile_data[name].setCollisionType(collision);
         }
+        setMaterial(name, flags, transforms_to);
       }
       else if (type == "single") {
         const auto& frame = tile["frames"][0];
@@ -74,6 +138,7 @@ TileDefLoader::TileDefLoader(std::string filename) {
         Vec2i origin(frame["origin"][0].asInt(), frame["origin"][1].asInt());
         tile_data[name].pushFrame(texture, origin, 0.f);
         tile_data[name].setCollisionType(collision);
+        setMaterial(name, flags, transforms_to);
       }
     }
   }
@@ -82,9 +147,48 @@ TileDefLoader::TileDefLoader(std::string filename) {
   }
 }
 
+void TileDefLoader::setMaterial(const TileType& name, std::optional<UInt32> flags,
+                                TileType transforms_to) {
+  if (not flags.has_value()) {
+    auto iter = legacy_flags.find(name);
+    flags = iter != legacy_flags.end() ? iter->second : TileDef::Flags::NONE;
+
+    auto transform = legacy_transforms.find(name);
+    if (transforms_to.empty() and transform != legacy_transforms.end()) {
+      transforms_to = transform->second;
+    }
+
+    static bool warned = false;
+    if (not warned and (iter != legacy_flags.end() or transform != legacy_transforms.end())) {
+      std::cerr << name << ": no \"flags\" in tile definition, "
+                << "using deprecated name-based defaults\n";
+      warned = true;
+    }
+  }
+
+  if (not transforms_to.empty()) {
+    *flags |= TileDef::Flags::TRANSFORMS;
+    transform_types[name] = std::move(transforms_to);
+  }
+  else {
+    transform_types.erase(name);
+  }
+
+  tile_data[name].setFlags(*flags);
+}
+
 void TileDefLoader::load(TileDefs& tiledefs) {
   for (auto i : tile_data) {
     tiledefs.registerTileDef(i.first, i.second);
   }
+
+  for (const auto& i : transform_types) {
+    auto target = tile_data.find(i.second);
+    if (target == tile_data.end()) {
+      throw std::runtime_error("tile \"" + i.first + "\" transforms to undefined tile \""
+                               + i.second + "\"");
+    }
+    tiledefs.getTileDef(i.first).setTransformTarget(tiledefs.getTileID(i.second));
+  }
 }
 }
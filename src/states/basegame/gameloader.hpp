@@ -4,18 +4,26 @@
 #include "../../types.hpp"
 #include "tiledefs.hpp"
 
+#include <optional>
 #include <string>
 
 namespace kme {
 class TileDefLoader {
 public:
   static const StringTable<TileDef::CollisionType> collision_table;
+  static const StringTable<UInt32> flag_table;
 
   TileDefLoader(std::string filename = "tiledefs.json");
 
   void load(TileDefs& tiledefs);
 
 private:
+  // tiles without a "flags" key fall back to the flags they used to be
+  // recognized by name for
+  void setMaterial(const TileType& name, std::optional<UInt32> flags, TileType transforms_to);
+
   StringTable<TileDef> tile_data;
+  // targets of TRANSFORMS tiles, resolved to IDs once everything is registered
+  StringTable<TileType> transform_types;
 };
 }
@@ -0,0 +1,438 @@
+#include "levelfile.hpp"
+
+#include "../../math.hpp"
+#include "../../types.hpp"
+#include "../../util.hpp"
+
+#include <json/reader.h>
+#include <json/value.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace kme {
+// begin binary helpers
+static void writeU16(std::vector<char>& out, UInt16 value) {
+  out.push_back(value & 0xFF);
+  out.push_back(value >> 8 & 0xFF);
+}
+
+static void writeU32(std::vector<char>& out, UInt32 value) {
+  for (std::size_t i = 0; i < 4; ++i) {
+    out.push_back(value >> (i * 8) & 0xFF);
+  }
+}
+
+static void writeI32(std::vector<char>& out, Int32 value) {
+  writeU32(out, static_cast<UInt32>(value));
+}
+
+static void writeF32(std::vector<char>& out, float value) {
+  UInt32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  writeU32(out, bits);
+}
+
+static void writeString(std::vector<char>& out, const std::string& str) {
+  if (str.size() > 0xFFFF) {
+    throw LevelFileError("string too long for level file: " + str.substr(0, 32));
+  }
+  writeU16(out, str.size());
+  out.insert(out.end(), str.begin(), str.end());
+}
+
+static void patchU32(std::vector<char>& out, std::size_t pos, UInt32 value) {
+  for (std::size_t i = 0; i < 4; ++i) {
+    out[pos + i] = value >> (i * 8) & 0xFF;
+  }
+}
+
+class BinaryReader {
+public:
+  BinaryReader(const std::vector<char>& data, std::size_t pos = 0) : data(data), pos(pos) {}
+
+  const char* take(std::size_t size) {
+    if (pos + size > data.size() or pos + size < pos) {
+      throw LevelFileError("level file is truncated");
+    }
+    const char* result = data.data() + pos;
+    pos += size;
+    return result;
+  }
+
+  UInt16 readU16() {
+    auto bytes = reinterpret_cast<const UInt8*>(take(2));
+    return bytes[0] | bytes[1] << 8;
+  }
+
+  UInt32 readU32() {
+    auto bytes = reinterpret_cast<const UInt8*>(take(4));
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<UInt32>(bytes[3]) << 24;
+  }
+
+  Int32 readI32() {
+    return static_cast<Int32>(readU32());
+  }
+
+  float readF32() {
+    UInt32 bits = readU32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::string readString() {
+    std::size_t size = readU16();
+    return std::string(take(size), size);
+  }
+
+  // rejects a count of records, each at least record_size bytes long, that
+  // could not fit in the rest of the data, before anything is sized by it
+  std::size_t checkCount(std::size_t count, std::size_t record_size) const {
+    if (count > (data.size() - pos) / record_size) {
+      throw LevelFileError("level file is truncated");
+    }
+    return count;
+  }
+
+private:
+  const std::vector<char>& data;
+  std::size_t pos;
+};
+
+// smallest encoded size of each kind of record, for checking counts
+static constexpr std::size_t type_size_min = 2;
+static constexpr std::size_t subworld_size_min = 4 + 4 * 4 + 2 + 2 + 1 + 4 + 4 + 4;
+static constexpr std::size_t entity_size = 3 * 4;
+static constexpr std::size_t layer_size_min = 5 * 4;
+// end binary helpers
+
+// files are read without a terminating NUL, so parse them by range
+static bool parseJSON(Json::Reader& reader, const std::vector<char>& data, Json::Value& root) {
+  return reader.parse(data.data(), data.data() + data.size(), root);
+}
+
+// begin LevelFile
+std::string LevelFile::getPath(std::size_t world, std::size_t level) {
+  std::stringstream path;
+  path << "/maps/" << world << "-" << level;
+  return path.str();
+}
+
+std::string LevelFile::getCompiledPath(std::size_t world, std::size_t level) {
+  return getPath(world, level) + ".kmel";
+}
+
+LevelFile LevelFile::fromJSON(std::size_t world, std::size_t level) {
+  LevelFile result;
+  result.types.push_back("");
+
+  StringTable<UInt32> type_indices = {{"", 0}};
+  auto getTypeIndex = [&](const std::string& type) -> UInt32 {
+    auto iter = type_indices.find(type);
+    if (iter == type_indices.end()) {
+      if (result.types.size() > 0xFFFF) {
+        throw LevelFileError("too many tile and entity types for level file");
+      }
+      iter = type_indices.emplace(type, result.types.size()).first;
+      result.types.push_back(type);
+    }
+    return iter->second;
+  };
+
+  Json::Reader reader;
+
+  std::string path = getPath(world, level);
+  StringList files = util::getFiles(path);
+
+  for (const auto& filename : files) {
+    Subworld& subworld = result.subworlds.emplace_back();
+    subworld.id = std::stoi(filename);
+
+    std::unordered_map<std::size_t, std::string> tileset_types;
+
+    Json::Value root;
+    if (parseJSON(reader, util::readFile(util::join({path, filename}, "/")), root)) {
+      subworld.bounds = Rect<int>(0, 0, root["width"].asInt(), root["height"].asInt());
+    }
+    else {
+      throw std::runtime_error(filename + " " + reader.getFormattedErrorMessages());
+    }
+
+    for (const auto& tileset : root["tilesets"]) {
+      std::size_t firstgid = tileset["firstgid"].asInt();
+      std::string source = tileset["source"].asString();
+      std::string tileset_path = util::join({path, source}, "/");
+
+      Json::Value tileset_root;
+      if (parseJSON(reader, util::readFile(tileset_path), tileset_root)) {
+        for (const auto& tiles : tileset_root["tiles"]) {
+          std::size_t id = tiles["id"].asInt() + firstgid;
+          tileset_types[id] = tiles["type"].asString();
+        }
+      }
+    }
+
+    std::size_t tilelayer_count = 0;
+    for (const auto& layer : root["layers"]) {
+      if (layer["type"] == "tilelayer") {
+        tilelayer_count += 1;
+      }
+    }
+
+    for (const auto& properties : root["properties"]) {
+      if (properties["name"] == "theme") {
+        subworld.theme = properties["value"].asString();
+      }
+      else if (properties["name"] == "broadphase") {
+        subworld.broadphase = properties["value"].asString();
+      }
+    }
+
+    const Rect<int> chunk_bounds(
+      0, 0, (subworld.bounds.width + 15) / 16, (subworld.bounds.height + 15) / 16
+    );
+
+    for (const auto& layer : root["layers"]) {
+      if (layer["type"] == "tilelayer") {
+        tilelayer_count -= 1;
+        Layer& layer_data = subworld.layers.emplace_back();
+        layer_data.index = tilelayer_count;
+        layer_data.chunk_bounds = chunk_bounds;
+        layer_data.tiles.resize(chunk_bounds.width * chunk_bounds.height * 256);
+
+        auto data = util::base64_decode(layer["data"].asString());
+        for (std::size_t i = 0; i < data.size(); i += 4) {
+          std::size_t id = 0;
+          // convert to little-endian
+          for (std::size_t j = 0; j < 4; ++j) {
+            id += static_cast<UInt8>(data[i + j]) << (j * 8);
+          }
+          auto it = tileset_types.find(id);
+          if (it == tileset_types.end()) {
+            continue;
+          }
+          int x = (i / 4) % subworld.bounds.width;
+          int y = subworld.bounds.height - (i / 4) / subworld.bounds.width - 1;
+          std::size_t chunk = (y / 16) * chunk_bounds.width + x / 16;
+          layer_data.tiles[chunk * 256 + y % 16 * 16 + x % 16] = getTypeIndex(it->second);
+        }
+      }
+      else if (layer["type"] == "objectgroup") {
+        for (auto object : layer["objects"]) {
+          auto aabb = Rect<float>(
+            object["x"].asFloat() / 16.f, subworld.bounds.height - object["y"].asFloat() / 16.f,
+            object["width"].asFloat() / 16.f, object["height"].asFloat() / 16.f
+          );
+          auto pos = Vec2f(aabb.x + aabb.width / 2, aabb.y);
+          auto it = tileset_types.find(object["gid"].asInt());
+          if (it != tileset_types.end()) {
+            subworld.entity_types.push_back(getTypeIndex(it->second));
+            subworld.entity_pos.push_back(pos);
+          }
+        }
+      }
+      else if (layer["type"] == "imagelayer") {
+        if (layer["name"] == "Water Layer") {
+          subworld.water_height = std::round(subworld.bounds.height - layer["offsety"].asFloat() / 16);
+        }
+      }
+    }
+  }
+
+  return result;
+}
+
+LevelFile LevelFile::fromBinary(const std::vector<char>& data, bool with_tiles) {
+  LevelFile result;
+  BinaryReader reader(data);
+
+  if (std::memcmp(reader.take(sizeof(magic)), magic, sizeof(magic)) != 0) {
+    throw LevelFileError("not a compiled level file");
+  }
+  if (UInt16 file_version = reader.readU16(); file_version != version) {
+    throw LevelFileError("unsupported level file version " + std::to_string(file_version));
+  }
+
+  std::size_t subworld_count = reader.readU16();
+
+  std::size_t type_count = reader.checkCount(reader.readU32(), type_size_min);
+  result.types.reserve(type_count);
+  for (std::size_t i = 0; i < type_count; ++i) {
+    result.types.push_back(reader.readString());
+  }
+  if (type_count == 0 or not result.types[0].empty()) {
+    throw LevelFileError("level file types do not start with the empty tile");
+  }
+
+  result.subworlds.resize(reader.checkCount(subworld_count, subworld_size_min));
+  for (auto& subworld : result.subworlds) {
+    subworld.id = reader.readU32();
+    subworld.bounds.x = reader.readI32();
+    subworld.bounds.y = reader.readI32();
+    subworld.bounds.width = reader.readI32();
+    subworld.bounds.height = reader.readI32();
+    subworld.theme = reader.readString();
+    subworld.broadphase = reader.readString();
+
+    bool has_water = reader.take(1)[0] != 0;
+    Int32 water_height = reader.readI32();
+    if (has_water) {
+      subworld.water_height = water_height;
+    }
+
+    std::size_t entity_count = reader.checkCount(reader.readU32(), entity_size);
+    subworld.entity_types.reserve(entity_count);
+    subworld.entity_pos.reserve(entity_count);
+    for (std::size_t i = 0; i < entity_count; ++i) {
+      UInt32 type = reader.readU32();
+      if (type >= type_count) {
+        throw LevelFileError("entity type out of range in level file");
+      }
+      subworld.entity_types.push_back(type);
+      float x = reader.readF32();
+      float y = reader.readF32();
+      subworld.entity_pos.push_back(Vec2f(x, y));
+    }
+
+    subworld.layers.resize(reader.checkCount(reader.readU32(), layer_size_min));
+    for (auto& layer : subworld.layers) {
+      layer.index = reader.readI32();
+      layer.chunk_bounds.x = reader.readI32();
+      layer.chunk_bounds.y = reader.readI32();
+      layer.chunk_bounds.width = reader.readI32();
+      layer.chunk_bounds.height = reader.readI32();
+      if (layer.chunk_bounds.width < 0 or layer.chunk_bounds.height < 0) {
+        throw LevelFileError("negative chunk bounds in level file");
+      }
+
+      const std::size_t width = layer.chunk_bounds.width;
+      const std::size_t height = layer.chunk_bounds.height;
+      if (height != 0 and width > SIZE_MAX / height) {
+        throw LevelFileError("chunk bounds too large in level file");
+      }
+      std::size_t chunk_count = reader.checkCount(width * height, 4);
+      layer.chunk_offsets.reserve(chunk_count);
+      for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        layer.chunk_offsets.push_back(reader.readU32());
+      }
+
+      if (with_tiles) {
+        layer.tiles.resize(chunk_count * 256);
+        for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+          decodeChunk(data, layer.chunk_offsets[chunk], type_count, &layer.tiles[chunk * 256]);
+        }
+      }
+    }
+  }
+
+  return result;
+}
+
+void LevelFile::decodeChunk(const std::vector<char>& data, std::size_t offset,
+                            std::size_t type_count, UInt16* tiles) {
+  BinaryReader reader(data, offset);
+
+  switch (static_cast<ChunkEncoding>(reader.readU16())) {
+  case ChunkEncoding::UNIFORM:
+    std::fill(tiles, tiles + 256, reader.readU16());
+    break;
+  case ChunkEncoding::DENSE:
+    for (std::size_t i = 0; i < 256; ++i) {
+      tiles[i] = reader.readU16();
+    }
+    break;
+  default:
+    throw LevelFileError("unknown chunk encoding in level file");
+  }
+
+  for (std::size_t i = 0; i < 256; ++i) {
+    if (tiles[i] >= type_count) {
+      throw LevelFileError("tile type out of range in level file");
+    }
+  }
+}
+
+std::vector<char> LevelFile::toBinary() const {
+  std::vector<char> out;
+
+  if (subworlds.size() > 0xFFFF) {
+    throw LevelFileError("too many subworlds for level file");
+  }
+
+  out.insert(out.end(), magic, magic + sizeof(magic));
+  writeU16(out, version);
+  writeU16(out, subworlds.size());
+
+  writeU32(out, types.size());
+  for (const auto& type : types) {
+    writeString(out, type);
+  }
+
+  // chunk offsets are patched in once the chunk records have been laid out
+  std::vector<std::pair<std::size_t, const UInt16*>> chunk_slots;
+
+  for (const auto& subworld : subworlds) {
+    writeU32(out, subworld.id);
+    writeI32(out, subworld.bounds.x);
+    writeI32(out, subworld.bounds.y);
+    writeI32(out, subworld.bounds.width);
+    writeI32(out, subworld.bounds.height);
+    writeString(out, subworld.theme);
+    writeString(out, subworld.broadphase);
+    out.push_back(subworld.water_height.has_value());
+    writeI32(out, subworld.water_height.value_or(0));
+
+    writeU32(out, subworld.entity_types.size());
+    for (std::size_t i = 0; i < subworld.entity_types.size(); ++i) {
+      writeU32(out, subworld.entity_types[i]);
+      writeF32(out, subworld.entity_pos[i].x);
+      writeF32(out, subworld.entity_pos[i].y);
+    }
+
+    writeU32(out, subworld.layers.size());
+    for (const auto& layer : subworld.layers) {
+      writeI32(out, layer.index);
+      writeI32(out, layer.chunk_bounds.x);
+      writeI32(out, layer.chunk_bounds.y);
+      writeI32(out, layer.chunk_bounds.width);
+      writeI32(out, layer.chunk_bounds.height);
+
+      for (std::size_t chunk = 0; chunk < layer.tiles.size() / 256; ++chunk) {
+        chunk_slots.emplace_back(out.size(), &layer.tiles[chunk * 256]);
+        writeU32(out, 0);
+      }
+    }
+  }
+
+  for (const auto& slot : chunk_slots) {
+    if (out.size() > 0xFFFFFFFF) {
+      throw LevelFileError("level too large for level file");
+    }
+    patchU32(out, slot.first, out.size());
+
+    const UInt16* tiles = slot.second;
+    if (std::all_of(tiles, tiles + 256, [&](UInt16 tile) { return tile == tiles[0]; })) {
+      writeU16(out, static_cast<UInt16>(ChunkEncoding::UNIFORM));
+      writeU16(out, tiles[0]);
+    }
+    else {
+      writeU16(out, static_cast<UInt16>(ChunkEncoding::DENSE));
+      for (std::size_t i = 0; i < 256; ++i) {
+        writeU16(out, tiles[i]);
+      }
+    }
+  }
+
+  return out;
+}
+// end LevelFile
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../../math.hpp"
+#include "../../types.hpp"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace kme {
+using namespace vec2_aliases;
+
+class LevelFileError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+// Tiledefs-independent contents of a level, as read from the Tiled maps in
+// /maps/W-L or from the compiled /maps/W-L.kmel written by kme-levelc.
+//
+// Compiled files are little-endian and laid out as:
+//
+//   "KMEL", u16 version, u16 subworld count
+//   u32 type count, then each type as u16 length and its characters
+//   per subworld:
+//     u32 id, i32 bounds x/y/width/height, theme as u16 length and characters,
+//     broadphase name as u16 length and characters,
+//     u8 has water, i32 water height,
+//     u32 entity count, then u32 type, f32 x, f32 y per entity,
+//     u32 layer count, then per layer:
+//       i32 index, i32 chunk bounds x/y/width/height,
+//       u32 file offset of every chunk, row-major over the chunk bounds
+//   chunk records: u16 encoding, then one u16 type for UNIFORM chunks or 256
+//   row-major u16 types for DENSE ones
+class LevelFile {
+public:
+  enum class ChunkEncoding : UInt16 {
+    UNIFORM, DENSE
+  };
+
+  struct Layer {
+    int index;
+    Rect<int> chunk_bounds;
+    // 256 row-major type indices per chunk, chunks row-major over chunk_bounds
+    std::vector<UInt16> tiles;
+    // file offset of every chunk record, only set when read from a binary
+    std::vector<UInt32> chunk_offsets;
+  };
+
+  struct Subworld {
+    std::size_t id;
+    Rect<int> bounds;
+    std::string theme;
+    // name of the collision broadphase, empty for the engine's default
+    std::string broadphase;
+    std::optional<int> water_height;
+    std::vector<UInt32> entity_types;
+    std::vector<Vec2f> entity_pos;
+    std::vector<Layer> layers;
+  };
+
+  static constexpr char magic[4] = {'K', 'M', 'E', 'L'};
+  static constexpr UInt16 version = 2;
+
+  static std::string getPath(std::size_t world, std::size_t level);
+  static std::string getCompiledPath(std::size_t world, std::size_t level);
+
+  static LevelFile fromJSON(std::size_t world, std::size_t level);
+  // with_tiles = false only reads the chunk offsets, for streaming chunks
+  // in later with decodeChunk; damaged data throws LevelFileError
+  static LevelFile fromBinary(const std::vector<char>& data, bool with_tiles = true);
+  std::vector<char> toBinary() const;
+
+  // the largest a chunk record can be
+  static constexpr std::size_t chunk_record_max = 2 + 256 * 2;
+
+  // decodes the chunk record at offset in data into 256 type indices
+  static void decodeChunk(const std::vector<char>& data, std::size_t offset,
+                          std::size_t type_count, UInt16* tiles);
+
+  // tile and entity type names; types[0] is always the empty tile
+  std::vector<std::string> types;
+  std::vector<Subworld> subworlds;
+};
+}
@@ -2,111 +2,135 @@
 
 #include "../../types.hpp"
 #include "../../util.hpp"
+#include "chunkstreamer.hpp"
+#include "levelfile.hpp"
 #include "tiledefs.hpp"
 #include "tilemap.hpp"
 
-#include <json/reader.h>
-#include <json/value.h>
+#include <physfs.h>
 
-#include <functional>
-#include <stdexcept>
+#include <memory>
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace kme {
-LevelLoader::LevelLoader(std::size_t world, std::size_t level) {
-  Json::Reader reader;
+static PHYSFS_sint64 getModTime(const std::string& path) {
+  PHYSFS_Stat stat;
+  return PHYSFS_stat(path.c_str(), &stat) != 0 ? stat.modtime : -1;
+}
 
-  std::stringstream path;
-  path << "/maps/" << world << "-" << level;
-  StringList files = util::getFiles(path.str());
+// a compiled level is only used while no map it was built from is newer
+static bool isCompiledCurrent(std::size_t world, std::size_t level) {
+  PHYSFS_sint64 compiled_time = getModTime(LevelFile::getCompiledPath(world, level));
+  if (compiled_time < 0) {
+    return false;
+  }
 
-  for (const auto& filename : files) {
-    std::size_t subworld_id = std::stoi(filename);
-    SubworldData& subworld_data = subworlds[subworld_id];
+  std::string path = LevelFile::getPath(world, level);
+  if (PHYSFS_exists(path.c_str())) {
+    for (const auto& filename : util::getFiles(path)) {
+      if (getModTime(util::join({path, filename}, "/")) > compiled_time) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
 
-    std::unordered_map<std::size_t, TileType> tileset_types;
+LevelLoader::LevelLoader(const TileDefs& tiledefs, std::size_t world, std::size_t level,
+                         std::size_t chunk_budget) {
+  // prefer the compiled level when kme-levelc has been run over the current
+  // maps; its chunks are decoded per subworld below, or streamed in later
+  std::string compiled_path = LevelFile::getCompiledPath(world, level);
+  bool compiled = isCompiledCurrent(world, level);
+  std::vector<char> data;
+  LevelFile level_file;
+  if (compiled) {
+    data = util::readFile(compiled_path);
+    level_file = LevelFile::fromBinary(data, false);
+  }
+  else {
+    level_file = LevelFile::fromJSON(world, level);
+  }
 
-    Json::Value root;
-    if (reader.parse(util::readFile(util::join({path.str(), filename}, "/")).data(), root)) {
-      subworld_data.bounds.width = root["width"].asInt();
-      subworld_data.bounds.height = root["height"].asInt();
+  // entity types share the table, so tile ids are resolved on first use
+  std::vector<std::optional<TileID>> tile_ids(level_file.types.size());
+  tile_ids[0] = Tilemap::notile;
+
+  for (std::size_t index = 0; index < level_file.subworlds.size(); ++index) {
+    const auto& subworld = level_file.subworlds[index];
+    SubworldData& subworld_data = subworlds[subworld.id];
+    subworld_data.bounds = subworld.bounds;
+    subworld_data.theme = subworld.theme;
+    subworld_data.water_height = subworld.water_height;
+    if (not subworld.broadphase.empty()) {
+      auto iter = Broadphase::type_table.find(subworld.broadphase);
+      if (iter == Broadphase::type_table.end()) {
+        throw LevelFileError("unknown broadphase \"" + subworld.broadphase + "\"");
+      }
+      subworld_data.broadphase = iter->second;
     }
-    else {
-      throw std::runtime_error(filename + " " + reader.getFormattedErrorMessages());
+
+    for (std::size_t i = 0; i < subworld.entity_types.size(); ++i) {
+      subworld_data.entities.types.push_back(level_file.types[subworld.entity_types[i]]);
+      subworld_data.entities.pos.push_back(subworld.entity_pos[i]);
     }
 
-    for (const auto& tileset : root["tilesets"]) {
-      std::size_t firstgid = tileset["firstgid"].asInt();
-      std::string source = tileset["source"].asString();
-      std::string tileset_path = util::join({path.str(), source}, "/");
+    Tilemap& tilemap = subworld_data.tilemap;
+    tilemap.setTileDefs(tiledefs);
+    tilemap.setBounds(subworld.bounds);
 
-      Json::Value tileset_root;
-      if (reader.parse(util::readFile(tileset_path).data(), tileset_root)) {
-        for (const auto& tiles : tileset_root["tiles"]) {
-          std::size_t id = tiles["id"].asInt() + firstgid;
-          tileset_types[id] = tiles["type"].asString();
-        }
-      }
+    std::size_t chunk_count = 0;
+    for (const auto& layer : subworld.layers) {
+      chunk_count += layer.chunk_bounds.width * layer.chunk_bounds.height;
     }
 
-    std::size_t tilelayer_count = 0;
-    for (const auto& layer : root["layers"]) {
-      if (layer["type"] == "tilelayer") {
-        tilelayer_count += 1;
-      }
+    if (compiled and chunk_count > chunk_budget) {
+      subworld_data.streamer = std::make_shared<ChunkStreamer>(
+        compiled_path, level_file, index, tiledefs, chunk_budget
+      );
+      continue;
     }
 
-    for (const auto& properties : root["properties"]) {
-      if (properties["name"] == "theme") {
-        subworld_data.theme = properties["value"].asString();
-      }
-    }
+    UInt16 chunk_tiles[256];
+    for (const auto& layer : subworld.layers) {
+      const Rect<int>& chunk_bounds = layer.chunk_bounds;
+      const std::size_t layer_chunks = chunk_bounds.width * chunk_bounds.height;
+      for (std::size_t chunk = 0; chunk < layer_chunks; ++chunk) {
+        const int chunk_x = chunk_bounds.x + chunk % chunk_bounds.width;
+        const int chunk_y = chunk_bounds.y + chunk / chunk_bounds.width;
+        const UInt16* tiles = chunk_tiles;
+        if (compiled) {
+          LevelFile::decodeChunk(data, layer.chunk_offsets[chunk], level_file.types.size(), chunk_tiles);
+        }
+        else {
+          tiles = &layer.tiles[chunk * 256];
+        }
 
-    for (const auto& layer : root["layers"]) {
-      if (layer["type"] == "tilelayer") {
-        tilelayer_count -= 1;
-        auto layer_data = util::base64_decode(layer["data"].asString());
-        for (std::size_t i = 0; i < layer_data.size(); i += 4) {
-          std::size_t id = 0;
-          // convert to little-endian
-          for (std::size_t j = 0; j < 4; ++j) {
-            id += static_cast<UInt8>(layer_data[i + j]) << (j * 8);
-          }
-          int x = (i / 4) % subworld_data.bounds.width;
-          int y = subworld_data.bounds.height - (i / 4) / subworld_data.bounds.width - 1;
-          auto it = tileset_types.find(id);
-          if (it != tileset_types.end()) {
-            subworld_data.tilemap.setTile(tilelayer_count, x, y, it->second);
+        for (std::size_t i = 0; i < 256; ++i) {
+          if (tiles[i] == 0) {
+            continue;
           }
-        }
-      }
-      else if (layer["type"] == "objectgroup") {
-        for (auto object : layer["objects"]) {
-          auto aabb = Rect<float>(
-            object["x"].asFloat() / 16.f, subworld_data.bounds.height - object["y"].asFloat() / 16.f,
-            object["width"].asFloat() / 16.f, object["height"].asFloat() / 16.f
-          );
-          auto pos = Vec2f(aabb.x + aabb.width / 2, aabb.y);
-          auto it = tileset_types.find(object["gid"].asInt());
-          if (it != tileset_types.end()) {
-            subworld_data.entities.types.push_back(it->second);
-            subworld_data.entities.pos.push_back(pos);
+          auto& tile_id = tile_ids[tiles[i]];
+          if (not tile_id.has_value()) {
+            tile_id = tiledefs.getTileID(level_file.types[tiles[i]]);
           }
-        }
-      }
-      else if (layer["type"] == "imagelayer") {
-        if (layer["name"] == "Water Layer") {
-          subworld_data.water_height = std::round(subworld_data.bounds.height - layer["offsety"].asFloat() / 16);
+          tilemap.setTile(layer.index, chunk_x * 16 + i % 16, chunk_y * 16 + i / 16, *tile_id);
         }
       }
     }
+
+    // loading is not an edit
+    tilemap.compact();
+    tilemap.clearJournal();
+    tilemap.clearDirtyChunks();
   }
 }
 
 void LevelLoader::load(Level& level) {
-  for (auto iter : subworlds) {
+  for (auto& iter : subworlds) {
     std::size_t index = iter.first;
     auto& subworld_data = iter.second;
 
@@ -116,10 +140,16 @@ void LevelLoader::load(Level& level) {
 
     Subworld& subworld = level.getSubworld(index);
     subworld.setBounds(subworld_data.bounds);
-    subworld.setTheme(subworld_data.theme);
-    subworld.setEntities(subworld_data.entities);
-    subworld.setTilemap(subworld_data.tilemap);
+    subworld.setTheme(std::move(subworld_data.theme));
+    subworld.setEntities(std::move(subworld_data.entities));
+    subworld.setTilemap(std::move(subworld_data.tilemap));
+    subworld.setChunkStreamer(std::move(subworld_data.streamer));
     subworld.setWaterHeight(subworld_data.water_height);
+    if (subworld_data.broadphase) {
+      subworld.setBroadphaseType(*subworld_data.broadphase);
+    }
   }
+
+  subworlds.clear();
 }
 }
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "../../math.hpp"
+#include "broadphase.hpp"
+#include "chunkstreamer.hpp"
 #include "entity.hpp"
+#include "tiledefs.hpp"
 #include "tilemap.hpp"
 #include "world.hpp"
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -18,10 +22,20 @@ public:
     Rect<int> bounds;
     std::string theme;
     std::optional<int> water_height;
+    // the subworld's default when the map doesn't pick one
+    std::optional<Broadphase::Type> broadphase;
+    std::shared_ptr<ChunkStreamer> streamer;
   };
 
-  LevelLoader(std::size_t world, std::size_t level);
+  // about 768 KiB worth of dense chunks
+  static constexpr std::size_t default_chunk_budget = 1024;
 
+  // Subworlds of compiled levels with more chunks than chunk_budget are
+  // streamed in around the camera instead of being loaded up front
+  LevelLoader(const TileDefs& tiledefs, std::size_t world, std::size_t level,
+              std::size_t chunk_budget = default_chunk_budget);
+
+  // moves the loaded subworlds into level, leaving the loader empty
   void load(Level& level);
 
 private:
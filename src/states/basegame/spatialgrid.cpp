@@ -0,0 +1,135 @@
+#include "spatialgrid.hpp"
+
+#include "../../math.hpp"
+#include "../../types.hpp"
+#include "entity.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+
+namespace kme {
+static bool inRange(Rect<int> range, int x, int y) {
+  return x >= range.x and x < range.x + range.width
+  and    y >= range.y and y < range.y + range.height;
+}
+
+SpatialGrid::SpatialGrid(float cell_size) : cell_size(cell_size) {}
+
+Broadphase::Type SpatialGrid::getType() const {
+  return Type::GRID;
+}
+
+float SpatialGrid::getCellSize() const {
+  return cell_size;
+}
+
+void SpatialGrid::clear() {
+  items.clear();
+  indices.clear();
+  for (auto& cell : cells) {
+    cell.second.clear();
+  }
+}
+
+Rect<int> SpatialGrid::getCellRange(Rect<float> aabb) const {
+  const int x1 = std::floor(aabb.x / cell_size);
+  const int y1 = std::floor(aabb.y / cell_size);
+  const int x2 = std::floor((aabb.x + aabb.width) / cell_size);
+  const int y2 = std::floor((aabb.y + aabb.height) / cell_size);
+  return Rect<int>(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+UInt64 SpatialGrid::getCellKey(int x, int y) {
+  return UInt64(UInt32(x)) << 32 | UInt32(y);
+}
+
+void SpatialGrid::insert(Entity entity, Rect<float> aabb) {
+  const std::size_t index = items.size();
+  items.push_back(Item {.entity = entity, .aabb = aabb});
+  indices.set(entity, index);
+
+  const Rect<int> range = getCellRange(aabb);
+  for (int y = range.y; y < range.y + range.height; ++y)
+  for (int x = range.x; x < range.x + range.width; ++x) {
+    cells[getCellKey(x, y)].push_back(index);
+  }
+}
+
+void SpatialGrid::update(Entity entity, Rect<float> aabb) {
+  const std::size_t index = indices.find(entity);
+  const Rect<int> range_old = getCellRange(items[index].aabb);
+  const Rect<int> range = getCellRange(aabb);
+  items[index].aabb = aabb;
+  if (range == range_old) {
+    return;
+  }
+
+  for (int y = range_old.y; y < range_old.y + range_old.height; ++y)
+  for (int x = range_old.x; x < range_old.x + range_old.width; ++x) {
+    if (not inRange(range, x, y)) {
+      auto& cell = cells[getCellKey(x, y)];
+      auto iter = std::find(cell.begin(), cell.end(), index);
+      *iter = cell.back();
+      cell.pop_back();
+    }
+  }
+
+  for (int y = range.y; y < range.y + range.height; ++y)
+  for (int x = range.x; x < range.x + range.width; ++x) {
+    if (not inRange(range_old, x, y)) {
+      cells[getCellKey(x, y)].push_back(index);
+    }
+  }
+}
+
+bool SpatialGrid::contains(Entity entity) const {
+  return indices.find(entity) != EntityIndices::none;
+}
+
+void SpatialGrid::query(Rect<float> region, std::vector<Item>& result) const {
+  result.clear();
+  found.clear();
+
+  // stamps mark items already found, so ones spanning cells come up once
+  if (stamps.size() < items.size()) {
+    stamps.resize(items.size(), stamp);
+  }
+  if (++stamp == 0) {
+    std::fill(stamps.begin(), stamps.end(), 0);
+    stamp = 1;
+  }
+
+  const Rect<int> range = getCellRange(region);
+  for (int y = range.y; y < range.y + range.height; ++y)
+  for (int x = range.x; x < range.x + range.width; ++x) {
+    auto cell = cells.find(getCellKey(x, y));
+    if (cell == cells.end()) {
+      continue;
+    }
+    for (std::size_t index : cell->second) {
+      if (stamps[index] != stamp) {
+        stamps[index] = stamp;
+        if (geo::intersects(items[index].aabb, region)) {
+          found.push_back(index);
+        }
+      }
+    }
+  }
+
+  std::sort(found.begin(), found.end());
+  for (std::size_t index : found) {
+    result.push_back(items[index]);
+  }
+}
+
+const std::vector<SpatialGrid::Item>& SpatialGrid::getItems() const {
+  return items;
+}
+
+std::size_t SpatialGrid::size() const {
+  return items.size();
+}
+}
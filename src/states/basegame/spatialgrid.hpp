@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../../math.hpp"
+#include "../../types.hpp"
+#include "broadphase.hpp"
+#include "entity.hpp"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+namespace kme {
+using namespace vec2_aliases;
+
+// Buckets entities by the cells of a uniform grid that their AABBs overlap,
+// so that region queries only visit entities near the region.
+class SpatialGrid final : public Broadphase {
+public:
+  SpatialGrid(float cell_size = 4.f);
+
+  Type getType() const final;
+  float getCellSize() const;
+
+  void clear() final;
+  void insert(Entity entity, Rect<float> aabb) final;
+  void update(Entity entity, Rect<float> aabb) final;
+  bool contains(Entity entity) const final;
+
+  void query(Rect<float> region, std::vector<Item>& result) const final;
+
+  const std::vector<Item>& getItems() const;
+  std::size_t size() const final;
+
+private:
+  Rect<int> getCellRange(Rect<float> aabb) const;
+  static UInt64 getCellKey(int x, int y);
+
+  float cell_size;
+  std::vector<Item> items;
+  // item indices per cell; emptied rather than erased so storage is reused
+  std::unordered_map<UInt64, std::vector<std::size_t>> cells;
+  EntityIndices indices;
+
+  mutable std::vector<std::size_t> found;
+  mutable std::vector<UInt32> stamps;
+  mutable UInt32 stamp = 0;
+};
+}
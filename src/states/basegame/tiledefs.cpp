@@ -1,12 +1,15 @@
 #include "tiledefs.hpp"
 
+#include <limits>
 #include <sstream>
+#include <utility>
 
 #include <cmath>
 
 namespace kme {
 // begin TileDef
-TileDef::TileDef() : collision_type(CollisionType::SOLID) {}
+TileDef::TileDef()
+: collision_type(CollisionType::SOLID), flags(Flags::NONE), transform_target(0) {}
 
 TileDef::CollisionType TileDef::getCollisionType() const {
   return collision_type;
@@ -16,6 +19,26 @@ void TileDef::setCollisionType(CollisionType new_collision_type) {
   collision_type = new_collision_type;
 }
 
+UInt32 TileDef::getFlags() const {
+  return flags;
+}
+
+void TileDef::setFlags(UInt32 new_flags) {
+  flags = new_flags;
+}
+
+bool TileDef::hasFlag(UInt32 flag) const {
+  return flags & flag;
+}
+
+TileID TileDef::getTransformTarget() const {
+  return transform_target;
+}
+
+void TileDef::setTransformTarget(TileID new_transform_target) {
+  transform_target = new_transform_target;
+}
+
 void TileDef::pushFrame(std::string texture, Vec2i origin, float duration) {
   frames.pushFrame(RenderFrame {
     .texture = texture,
@@ -29,32 +52,16 @@ std::size_t TileDef::getFrameCount() const {
   return frames.getFrameCount();
 }
 
-// NOTE: this function has potential for optimization
 std::size_t TileDef::getFrameOffset(float time) const {
   return frames.getFrameOffset(time);
-
-  /*
-  float time_max = 0.f;
-
-  for (auto& frame : frames) {
-    time_max += frame.duration;
-  }
-
-  float time_mod = std::fmod(time, time_max);
-  float accumulator = 0.f;
-  std::size_t counter = 0;
-
-  while (time_mod >= accumulator) {
-    accumulator += frames[counter++].duration;
-  }
-
-  return (counter - 1) % frames.size();
-  */
 }
 
 const RenderFrame& TileDef::getFrame(std::size_t index) const {
   return frames.getFrame(index);
 }
+void TileDef::setFrame(std::size_t index, RenderFrame frame) {
+  frames.setFrame(index, std::move(frame));
+}
 // end TileDef
 
 // begin TileDefs
@@ -72,17 +79,69 @@ TileDefs::TileDefs(TileDef default_tile) {
   registerTileDef("", std::move(default_tile));
 }
 
-void TileDefs::registerTileDef(TileType tile_type, TileDef tiledef) {
-  if (tiledefs.find(tile_type) != tiledefs.end()) {
+TileID TileDefs::registerTileDef(TileType tile_type, TileDef tiledef) {
+  if (tile_ids.find(tile_type) != tile_ids.end()) {
     std::stringstream ss;
     ss << "attempted to redefine tile with id \"" << tile_type << "\"";
     throw TileRedefinitionError(ss.str());
   }
-  tiledefs[tile_type] = std::move(tiledef);
+  if (tiledefs.size() > std::numeric_limits<TileID>::max()) {
+    std::stringstream ss;
+    ss << "too many tiles defined while registering \"" << tile_type << "\"";
+    throw std::overflow_error(ss.str());
+  }
+
+  TileID tile_id = tiledefs.size();
+  tiledefs.push_back(std::move(tiledef));
+  frame_offsets.push_back(0);
+  tile_types.push_back(tile_type);
+  tile_ids[std::move(tile_type)] = tile_id;
+  return tile_id;
+}
+
+TileID TileDefs::getTileID(const TileType& tile_type) const {
+  return tile_ids.at(tile_type);
+}
+
+const TileType& TileDefs::getTileType(TileID tile_id) const {
+  return tile_types.at(tile_id);
+}
+
+std::size_t TileDefs::size() const {
+  return tiledefs.size();
+}
+
+// IDs only ever come from this registry, so skip the bounds check
+const TileDef& TileDefs::getTileDef(TileID tile_id) const {
+  return tiledefs[tile_id];
+}
+
+TileDef& TileDefs::getTileDef(TileID tile_id) {
+  return const_cast<TileDef&>(static_cast<const TileDefs*>(this)->getTileDef(tile_id));
+}
+
+const TileDef& TileDefs::getTileDef(const TileType& tile_type) const {
+  return getTileDef(getTileID(tile_type));
+}
+
+TileDef& TileDefs::getTileDef(const TileType& tile_type) {
+  return getTileDef(getTileID(tile_type));
+}
+
+void TileDefs::updateFrames(float time) {
+  for (std::size_t i = 0; i < tiledefs.size(); ++i) {
+    if (tiledefs[i].getFrameCount() > 1) {
+      frame_offsets[i] = tiledefs[i].getFrameOffset(time);
+    }
+  }
+}
+
+std::size_t TileDefs::getFrameOffset(TileID tile_id) const {
+  return frame_offsets[tile_id];
 }
 
-const TileDef& TileDefs::getTileDef(TileType tile_type) const {
-  return tiledefs.at(tile_type);
+const RenderFrame& TileDefs::getCurrentFrame(TileID tile_id) const {
+  return tiledefs[tile_id].getFrame(frame_offsets[tile_id]);
 }
 
 const TileDefs::const_iterator TileDefs::begin() const { return tiledefs.begin(); }
@@ -2,15 +2,17 @@
 
 #include "../../math.hpp"
 #include "../../renderstates.hpp"
+#include "../../types.hpp"
 
-#include <map>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace kme {
 using namespace vec2_aliases;
 
 using TileType = std::string;
+using TileID = UInt16;
 
 class TileRedefinitionError : public std::runtime_error {
 public:
@@ -19,7 +21,7 @@ public:
 
 class TileDef {
 public:
-  enum class CollisionType {
+  enum class CollisionType : UInt8 {
     NONE, NONSOLID, SOLID, PLATFORM, SLOPE, WATER, WATERFALL, LAVA
   };
 
@@ -32,27 +34,54 @@ public:
     CEIL_SLOPE_DOWN_GENTLE_TOP, CEIL_SLOPE_DOWN_GENTLE_BOTTOM
   };
 
+  // material and behavior of a tile, checked by collision handling
+  struct Flags {
+    enum : UInt32 {
+      NONE = 0,
+      SLIPPERY   = 1 << 0,
+      COIN       = 1 << 1, // collected by touching it
+      BUMPABLE   = 1 << 2,
+      BREAKABLE  = 1 << 3,
+      TRANSFORMS = 1 << 4,
+      BUMP_COIN  = 1 << 5  // gives a coin when bumped from below
+    };
+  };
+
   TileDef();
 
   CollisionType getCollisionType() const;
   void setCollisionType(CollisionType new_collision_type);
 
+  UInt32 getFlags() const;
+  void setFlags(UInt32 new_flags);
+  bool hasFlag(UInt32 flag) const;
+
+  // tile left behind when a TRANSFORMS tile is bumped
+  TileID getTransformTarget() const;
+  void setTransformTarget(TileID new_transform_target);
+
   std::size_t getFrameCount() const;
   std::size_t getFrameOffset(float time) const;
 
   const RenderFrame& getFrame(std::size_t index) const;
+  void setFrame(std::size_t index, RenderFrame frame);
   void pushFrame(std::string texture, Vec2i origin, float duration);
 
 private:
   CollisionType collision_type;
   SlopeType slope_type;
 
+  UInt32 flags;
+  TileID transform_target;
+
   RenderFrames frames;
 };
 
+// Tile types are interned as they are registered; the default tile is always
+// assigned ID 0, which doubles as Tilemap::notile
 class TileDefs {
 public:
-  using Map = std::map<TileType, TileDef>;
+  using Map = std::vector<TileDef>;
 
   using const_iterator = Map::const_iterator;
   using const_reverse_iterator = Map::const_reverse_iterator;
@@ -62,8 +91,22 @@ public:
   TileDefs();
   TileDefs(TileDef default_tile);
 
-  void registerTileDef(TileType tile_type, TileDef tiledef);
-  const TileDef& getTileDef(TileType tile_type) const;
+  TileID registerTileDef(TileType tile_type, TileDef tiledef);
+
+  TileID getTileID(const TileType& tile_type) const;
+  const TileType& getTileType(TileID tile_id) const;
+  std::size_t size() const;
+
+  const TileDef& getTileDef(TileID tile_id) const;
+  TileDef& getTileDef(TileID tile_id);
+  const TileDef& getTileDef(const TileType& tile_type) const;
+  TileDef& getTileDef(const TileType& tile_type);
+
+  // Animated tiles all run off the same clock, so their current frames are
+  // computed once per rendered frame into a table indexed by tile ID
+  void updateFrames(float time);
+  std::size_t getFrameOffset(TileID tile_id) const;
+  const RenderFrame& getCurrentFrame(TileID tile_id) const;
 
   const const_iterator cbegin() const;
   const const_iterator cend() const;
@@ -81,5 +124,8 @@ public:
 
 private:
   Map tiledefs;
+  std::vector<TileType> tile_types;
+  StringTable<TileID> tile_ids;
+  std::vector<std::size_t> frame_offsets;
 };
 }
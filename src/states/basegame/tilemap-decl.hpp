@@ -6,8 +6,10 @@
 
 #include <array>
 #include <map>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace kme {
 using namespace vec2_aliases;
@@ -16,19 +18,156 @@ struct Tile {
   int layer;
   Vec2i pos;
 
+  Tile();
   Tile(int layer, int x, int y);
 
   bool operator ==(const Tile& rhs) const;
   bool operator !=(const Tile& rhs) const;
 };
 
+// a single setTile that actually changed the map
+struct TileChange {
+  Tile tile;
+  TileID old_tile;
+  TileID new_tile;
+};
+
+struct ChunkRef {
+  int layer;
+  Vec2s pos;
+
+  bool operator ==(const ChunkRef& rhs) const;
+  bool operator !=(const ChunkRef& rhs) const;
+  bool operator <(const ChunkRef& rhs) const;
+};
+
 class Tilemap {
 public:
-  using Chunk = std::array<std::array<TileType, 16>, 16>;
-  using Chunks = std::unordered_map<Vec2s, Chunk>;
+  // Tiles are stored alongside the collision type of their tiledef, so the
+  // collision broadphase never has to go through TileDefs.
+  //
+  // A chunk filled with a single tile is stored as just that tile, and one
+  // with up to 16 distinct tiles as 4-bit indices into a palette. Both are
+  // kept inline, so only palette indices and dense arrays go on the heap.
+  // setTile promotes chunks a step at a time as they gain distinct tiles;
+  // compact() packs them back down.
+  class Chunk {
+  public:
+    enum class Storage {
+      UNIFORM, PALETTE, DENSE
+    };
+
+    struct Entry {
+      TileID tile;
+      TileDef::CollisionType collision;
+
+      bool operator ==(const Entry& rhs) const;
+      bool operator !=(const Entry& rhs) const;
+    };
+
+    static constexpr std::size_t PALETTE_MAX = 16;
+
+    Chunk();
+    Chunk(Entry uniform);
+
+    Storage getStorage() const;
+    bool isUniform() const;
+    Entry getUniform() const;
+
+    Entry getEntry(std::size_t x, std::size_t y) const;
+    TileID getTile(std::size_t x, std::size_t y) const;
+    TileDef::CollisionType getCollisionType(std::size_t x, std::size_t y) const;
+    // returns whether the cell changed
+    bool setEntry(std::size_t x, std::size_t y, Entry entry);
+
+    // row y of the tile and collision planes, or nullptr unless DENSE
+    const TileID* getTileRow(std::size_t y) const;
+    const TileDef::CollisionType* getCollisionRow(std::size_t y) const;
+
+    // re-packs the chunk into the smallest storage that can represent it
+    void compact();
+
+  private:
+    friend class Tilemap;
+
+    void promote();
+
+    // listed in the tilemap's dirty chunks since they were last drained
+    bool dirty = false;
+    Storage storage = Storage::UNIFORM;
+    // UNIFORM: the single entry; PALETTE: up to PALETTE_MAX entries
+    std::array<Entry, PALETTE_MAX> palette;
+    UInt8 palette_size = 1;
+    // PALETTE: two 4-bit palette indices per byte
+    std::vector<UInt8> indices;
+    // DENSE: one tile and one collision type per cell, row-major
+    std::vector<TileID> tiles;
+    std::vector<TileDef::CollisionType> collision;
+  };
+
+  // A run of horizontally adjacent tiles within one row of a chunk. Uniform
+  // spans have no per-tile arrays, every tile in them is the uniform entry.
+  struct Span {
+    int layer;
+    Vec2i pos;
+    std::size_t length;
+    const TileID* tiles;
+    const TileDef::CollisionType* collision;
+    Chunk::Entry uniform;
+
+    bool isUniform() const;
+    TileID getTile(std::size_t i) const;
+    TileDef::CollisionType getCollisionType(std::size_t i) const;
+  };
+
+  // Chunk storage for a single layer. Unbounded layers keep their chunks in a
+  // hash map; bounded layers additionally keep a row-major grid of chunks
+  // covering their bounds, so lookups inside them are plain index arithmetic.
+  // Chunks outside of the bounds still go to the hash map.
+  class Chunks {
+  public:
+    Chunks();
+    Chunks(Rect<int> chunk_bounds);
+
+    bool isDense() const;
+    Rect<int> getBounds() const;
+    std::size_t size() const;
+
+    const Chunk* find(Vec2s pos) const;
+    Chunk* find(Vec2s pos);
+
+    const Chunk& at(Vec2s pos) const;
+    Chunk& at(Vec2s pos);
+
+    Chunk& operator [](Vec2s pos);
+
+    // grid chunks are reset to an empty chunk, overflow chunks are removed
+    void erase(Vec2s pos);
+
+    // visits every chunk as f(Vec2s pos, [const] Chunk& chunk), grid first
+    template<typename F>
+    void forEach(F&& f) const;
+    template<typename F>
+    void forEach(F&& f);
+
+  private:
+    std::optional<std::size_t> getIndex(Vec2s pos) const;
+
+    Rect<int> bounds;
+    std::vector<Chunk> grid;
+    std::unordered_map<Vec2s, Chunk> overflow;
+  };
+
   using Layers = std::map<int, Chunks>;
 
-  inline static const TileType notile;
+  static constexpr TileID notile = 0;
+
+  Tilemap();
+  Tilemap(const TileDefs& tiledefs);
+
+  // tiledefs are needed to keep collision planes up to date in setTile
+  const TileDefs* getTileDefs() const;
+  void setTileDefs(const TileDefs& tiledefs);
 
   static constexpr Vec2s getChunkPos(int x, int y);
   static constexpr Vec2z getLocalPos(int x, int y);
@@ -36,6 +175,10 @@ public:
   const Layers& getLayers() const;
   Layers& getLayers();
 
+  // switches every layer, present and future, to dense storage
+  std::optional<Rect<int>> getBounds() const;
+  void setBounds(Rect<int> bounds);
+
   const Chunks& getChunks(int layer) const;
   Chunks& getChunks(int layer);
   void setChunks(int layer, const Chunks& chunks);
@@ -45,12 +188,61 @@ public:
   Chunk& getChunkAt(Tile tile);
   Chunk& getChunkAt(int layer, int x, int y);
 
-  TileType getTile(Tile tile) const;
-  TileType getTile(int layer, int x, int y) const;
-  void setTile(int layer, int x, int y, TileType tile_type);
-  void setTile(Tile tile, TileType tile_type);
+  // Whole-chunk replacement for chunk streaming. These don't go through the
+  // journal, but do mark the chunk dirty.
+  void setChunk(int layer, Vec2s pos, Chunk chunk);
+  void resetChunk(int layer, Vec2s pos);
+
+  TileID getTile(Tile tile) const;
+  TileID getTile(int layer, int x, int y) const;
+  void setTile(int layer, int x, int y, TileID tile_id);
+  void setTile(Tile tile, TileID tile_id);
+
+  // re-packs every chunk into its smallest representation
+  void compact();
+
+  // every change made by setTile since the last clearJournal(); Subworld
+  // clears it at the start of each tick, once the chunk streamer has read it
+  const std::vector<TileChange>& getJournal() const;
+  void clearJournal();
+
+  // chunks changed by setTile, setChunk or resetChunk since they were last
+  // drained, each listed once; the chunk mesh cache drains them every frame
+  const std::vector<ChunkRef>& getDirtyChunks() const;
+  // visits every dirty chunk as f(const ChunkRef& ref), then forgets them
+  template<typename F>
+  void drainDirtyChunks(F&& f);
+  void clearDirtyChunks();
+
+  TileDef::CollisionType getCollisionType(Tile tile) const;
+  TileDef::CollisionType getCollisionType(int layer, int x, int y) const;
+
+  // visits the part of range covered by existing chunks as f(const Span&),
+  // chunk by chunk and row by row within each chunk; spans only live for the
+  // duration of the call
+  template<typename F>
+  void forEachSpan(int layer, Rect<int> range, F&& f) const;
+  template<typename F>
+  void forEachSpan(Rect<int> range, F&& f) const;
+
+  // visits every tile in range, on every layer, whose collision type is not
+  // NONE as f(Tile tile, TileDef::CollisionType type)
+  template<typename F>
+  void forEachCollision(Rect<int> range, F&& f) const;
 
 private:
+  template<typename F>
+  static void forEachSpan(int layer, const Chunks& chunks, Rect<int> range, F& f);
+
+  Chunks& getOrCreateChunks(int layer);
+  void markDirty(int layer, Vec2s pos, Chunk& chunk);
+
+  const TileDefs* tiledefs = nullptr;
+
   Layers layers;
+  std::optional<Rect<int>> bounds;
+
+  std::vector<TileChange> journal;
+  std::vector<ChunkRef> dirty_chunks;
 };
 }
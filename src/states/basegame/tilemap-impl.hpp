@@ -3,6 +3,7 @@
 #include "../../math.hpp"
 #include "../../util.hpp"
 
+#include <algorithm>
 #include <functional>
 
 template<>
@@ -16,6 +17,141 @@ struct std::hash<kme::Tile> {
 };
 
 namespace kme {
+template<typename F>
+void Tilemap::Chunks::forEach(F&& f) const {
+  for (std::size_t i = 0; i < grid.size(); ++i) {
+    Vec2s pos(bounds.x + i % bounds.width, bounds.y + i / bounds.width);
+    f(pos, grid[i]);
+  }
+
+  for (const auto& iter : overflow) {
+    f(iter.first, iter.second);
+  }
+}
+
+template<typename F>
+void Tilemap::Chunks::forEach(F&& f) {
+  for (std::size_t i = 0; i < grid.size(); ++i) {
+    Vec2s pos(bounds.x + i % bounds.width, bounds.y + i / bounds.width);
+    f(pos, grid[i]);
+  }
+
+  for (auto& iter : overflow) {
+    f(iter.first, iter.second);
+  }
+}
+
+template<typename F>
+void Tilemap::drainDirtyChunks(F&& f) {
+  for (const auto& ref : dirty_chunks) {
+    auto iter = layers.find(ref.layer);
+    if (iter != layers.end()) {
+      if (Chunk* chunk = iter->second.find(ref.pos)) {
+        chunk->dirty = false;
+      }
+    }
+    f(ref);
+  }
+  dirty_chunks.clear();
+}
+
+template<typename F>
+void Tilemap::forEachSpan(int layer, Rect<int> range, F&& f) const {
+  auto iter = layers.find(layer);
+  if (iter != layers.end()) {
+    forEachSpan(iter->first, iter->second, range, f);
+  }
+}
+
+template<typename F>
+void Tilemap::forEachSpan(Rect<int> range, F&& f) const {
+  for (const auto& iter : layers) {
+    forEachSpan(iter.first, iter.second, range, f);
+  }
+}
+
+template<typename F>
+void Tilemap::forEachSpan(int layer, const Chunks& chunks, Rect<int> range, F& f) {
+  if (range.width <= 0 or range.height <= 0) {
+    return;
+  }
+
+  const Vec2s chunk_begin = getChunkPos(range.x, range.y);
+  const Vec2s chunk_end = getChunkPos(range.x + range.width - 1, range.y + range.height - 1);
+
+  // palette rows are unpacked here so that every span is contiguous
+  TileID row_tiles[16];
+  TileDef::CollisionType row_collision[16];
+
+  for (int chunk_y = chunk_begin.y; chunk_y <= chunk_end.y; ++chunk_y)
+  for (int chunk_x = chunk_begin.x; chunk_x <= chunk_end.x; ++chunk_x) {
+    const Chunk* chunk = chunks.find(Vec2s(chunk_x, chunk_y));
+    if (chunk == nullptr) {
+      continue;
+    }
+
+    const int y_begin = std::max(range.y, chunk_y * 16);
+    const int y_end = std::min(range.y + range.height, chunk_y * 16 + 16);
+    const int x_begin = std::max(range.x, chunk_x * 16);
+    const int x_end = std::min(range.x + range.width, chunk_x * 16 + 16);
+    const std::size_t local_x = x_begin - chunk_x * 16;
+
+    Span span {
+      .layer = layer,
+      .pos = Vec2i(x_begin, y_begin),
+      .length = static_cast<std::size_t>(x_end - x_begin),
+      .tiles = nullptr,
+      .collision = nullptr,
+      .uniform = chunk->isUniform() ? chunk->getUniform() : Chunk::Entry {}
+    };
+
+    for (int y = y_begin; y < y_end; ++y) {
+      const std::size_t local_y = y - chunk_y * 16;
+      span.pos.y = y;
+
+      switch (chunk->getStorage()) {
+      case Chunk::Storage::UNIFORM:
+        break;
+      case Chunk::Storage::PALETTE:
+        for (std::size_t i = 0; i < span.length; ++i) {
+          const Chunk::Entry entry = chunk->getEntry(local_x + i, local_y);
+          row_tiles[i] = entry.tile;
+          row_collision[i] = entry.collision;
+        }
+        span.tiles = row_tiles;
+        span.collision = row_collision;
+        break;
+      case Chunk::Storage::DENSE:
+        span.tiles = chunk->getTileRow(local_y) + local_x;
+        span.collision = chunk->getCollisionRow(local_y) + local_x;
+        break;
+      }
+
+      f(static_cast<const Span&>(span));
+    }
+  }
+}
+
+template<typename F>
+void Tilemap::forEachCollision(Rect<int> range, F&& f) const {
+  forEachSpan(range, [&f](const Span& span) {
+    if (span.isUniform()) {
+      if (span.uniform.collision != TileDef::CollisionType::NONE) {
+        for (std::size_t i = 0; i < span.length; ++i) {
+          f(Tile(span.layer, span.pos.x + i, span.pos.y), span.uniform.collision);
+        }
+      }
+      return;
+    }
+
+    for (std::size_t i = 0; i < span.length; ++i) {
+      if (span.collision[i] != TileDef::CollisionType::NONE) {
+        f(Tile(span.layer, span.pos.x + i, span.pos.y), span.collision[i]);
+      }
+    }
+  });
+}
+
 constexpr Vec2s Tilemap::getChunkPos(int x, int y) {
   return Vec2s(util::absdiv(x, 16), util::absdiv(y, 16));
 }
@@ -1,11 +1,20 @@
 #include "tilemap.hpp"
 
 #include "../../math.hpp"
+#include "../../util.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
 
 namespace kme {
 using namespace vec2_aliases;
 
 // begin Tile
+Tile::Tile() : Tile(0, 0, 0) {}
+
 Tile::Tile(int layer, int x, int y) : layer(layer), pos(x, y) {}
 
 bool Tile::operator ==(const Tile& rhs) const {
@@ -17,19 +26,364 @@ bool Tile::operator !=(const Tile& rhs) const {
 }
 // end Tile
 
+// begin ChunkRef
+bool ChunkRef::operator ==(const ChunkRef& rhs) const {
+  return layer == rhs.layer and pos == rhs.pos;
+}
+
+bool ChunkRef::operator !=(const ChunkRef& rhs) const {
+  return layer != rhs.layer or pos != rhs.pos;
+}
+
+bool ChunkRef::operator <(const ChunkRef& rhs) const {
+  return std::tie(layer, pos.y, pos.x) < std::tie(rhs.layer, rhs.pos.y, rhs.pos.x);
+}
+// end ChunkRef
+
+// begin Tilemap::Chunk
+bool Tilemap::Chunk::Entry::operator ==(const Entry& rhs) const {
+  return tile == rhs.tile and collision == rhs.collision;
+}
+
+bool Tilemap::Chunk::Entry::operator !=(const Entry& rhs) const {
+  return tile != rhs.tile or collision != rhs.collision;
+}
+
+Tilemap::Chunk::Chunk()
+: Chunk(Entry {.tile = notile, .collision = TileDef::CollisionType::NONE}) {}
+
+Tilemap::Chunk::Chunk(Entry uniform) : palette() {
+  palette[0] = uniform;
+}
+
+Tilemap::Chunk::Storage Tilemap::Chunk::getStorage() const {
+  return storage;
+}
+
+bool Tilemap::Chunk::isUniform() const {
+  return storage == Storage::UNIFORM;
+}
+
+Tilemap::Chunk::Entry Tilemap::Chunk::getUniform() const {
+  return palette[0];
+}
+
+Tilemap::Chunk::Entry Tilemap::Chunk::getEntry(std::size_t x, std::size_t y) const {
+  const std::size_t index = y * 16 + x;
+  switch (storage) {
+  case Storage::UNIFORM:
+    return palette[0];
+  case Storage::PALETTE:
+    return palette[indices[index / 2] >> (index % 2 * 4) & 0xF];
+  case Storage::DENSE:
+  default:
+    return Entry {.tile = tiles[index], .collision = collision[index]};
+  }
+}
+
+TileID Tilemap::Chunk::getTile(std::size_t x, std::size_t y) const {
+  if (storage == Storage::DENSE) {
+    return tiles[y * 16 + x];
+  }
+  return getEntry(x, y).tile;
+}
+
+TileDef::CollisionType Tilemap::Chunk::getCollisionType(std::size_t x, std::size_t y) const {
+  if (storage == Storage::DENSE) {
+    return collision[y * 16 + x];
+  }
+  return getEntry(x, y).collision;
+}
+
+bool Tilemap::Chunk::setEntry(std::size_t x, std::size_t y, Entry entry) {
+  if (getEntry(x, y) == entry) {
+    return false;
+  }
+
+  const std::size_t index = y * 16 + x;
+  switch (storage) {
+  case Storage::UNIFORM:
+    promote();
+    [[fallthrough]];
+  case Storage::PALETTE: {
+    auto palette_end = palette.begin() + palette_size;
+    auto iter = std::find(palette.begin(), palette_end, entry);
+    if (iter == palette_end and palette_size < PALETTE_MAX) {
+      *iter = entry;
+      ++palette_size;
+    }
+    if (iter - palette.begin() < palette_size) {
+      UInt8& byte = indices[index / 2];
+      const UInt8 shift = index % 2 * 4;
+      byte = (byte & ~(0xF << shift)) | (iter - palette.begin()) << shift;
+      return true;
+    }
+    promote();
+    break;
+  }
+  case Storage::DENSE:
+    break;
+  }
+
+  tiles[index] = entry.tile;
+  collision[index] = entry.collision;
+  return true;
+}
+
+const TileID* Tilemap::Chunk::getTileRow(std::size_t y) const {
+  return storage == Storage::DENSE ? &tiles[y * 16] : nullptr;
+}
+
+const TileDef::CollisionType* Tilemap::Chunk::getCollisionRow(std::size_t y) const {
+  return storage == Storage::DENSE ? &collision[y * 16] : nullptr;
+}
+
+// moves one step up, from UNIFORM to PALETTE or from PALETTE to DENSE
+void Tilemap::Chunk::promote() {
+  if (storage == Storage::UNIFORM) {
+    // every cell starts out as index 0, the uniform entry
+    storage = Storage::PALETTE;
+    indices.assign(128, 0);
+    return;
+  }
+
+  std::vector<TileID> tiles_new(256);
+  std::vector<TileDef::CollisionType> collision_new(256);
+  for (std::size_t y = 0; y < 16; ++y)
+  for (std::size_t x = 0; x < 16; ++x) {
+    Entry entry = getEntry(x, y);
+    tiles_new[y * 16 + x] = entry.tile;
+    collision_new[y * 16 + x] = entry.collision;
+  }
+
+  storage = Storage::DENSE;
+  tiles = std::move(tiles_new);
+  collision = std::move(collision_new);
+  palette_size = 0;
+  indices.clear();
+  indices.shrink_to_fit();
+}
+
+void Tilemap::Chunk::compact() {
+  if (storage == Storage::UNIFORM) {
+    return;
+  }
+
+  // palette chunks are re-packed too, dropping entries no longer in use
+  std::array<Entry, PALETTE_MAX> palette_new {};
+  std::size_t palette_size_new = 0;
+  std::array<UInt8, 128> indices_new {};
+  for (std::size_t index = 0; index < 256; ++index) {
+    Entry entry = getEntry(index % 16, index / 16);
+    auto palette_end = palette_new.begin() + palette_size_new;
+    auto iter = std::find(palette_new.begin(), palette_end, entry);
+    if (iter == palette_end) {
+      if (palette_size_new == PALETTE_MAX) {
+        return; // too heterogeneous, stay dense
+      }
+      *iter = entry;
+      ++palette_size_new;
+    }
+    indices_new[index / 2] |= (iter - palette_new.begin()) << (index % 2 * 4);
+  }
+
+  storage = palette_size_new == 1 ? Storage::UNIFORM : Storage::PALETTE;
+  palette = palette_new;
+  palette_size = palette_size_new;
+  if (storage == Storage::PALETTE) {
+    indices.assign(indices_new.begin(), indices_new.end());
+  }
+  else {
+    indices.clear();
+    indices.shrink_to_fit();
+  }
+  tiles.clear();
+  tiles.shrink_to_fit();
+  collision.clear();
+  collision.shrink_to_fit();
+}
+// end Tilemap::Chunk
+
+// begin Tilemap::Span
+bool Tilemap::Span::isUniform() const {
+  return tiles == nullptr;
+}
+
+TileID Tilemap::Span::getTile(std::size_t i) const {
+  return tiles ? tiles[i] : uniform.tile;
+}
+
+TileDef::CollisionType Tilemap::Span::getCollisionType(std::size_t i) const {
+  return collision ? collision[i] : uniform.collision;
+}
+// end Tilemap::Span
+
+// begin Tilemap::Chunks
+Tilemap::Chunks::Chunks() : bounds(0, 0, 0, 0) {}
+
+Tilemap::Chunks::Chunks(Rect<int> chunk_bounds)
+: bounds(chunk_bounds), grid(chunk_bounds.width * chunk_bounds.height, Chunk()) {}
+
+bool Tilemap::Chunks::isDense() const {
+  return not grid.empty();
+}
+
+Rect<int> Tilemap::Chunks::getBounds() const {
+  return bounds;
+}
+
+std::size_t Tilemap::Chunks::size() const {
+  return grid.size() + overflow.size();
+}
+
+std::optional<std::size_t> Tilemap::Chunks::getIndex(Vec2s pos) const {
+  int x = pos.x - bounds.x;
+  int y = pos.y - bounds.y;
+  if (x >= 0 and x < bounds.width and y >= 0 and y < bounds.height) {
+    return y * bounds.width + x;
+  }
+  return std::nullopt;
+}
+
+const Tilemap::Chunk* Tilemap::Chunks::find(Vec2s pos) const {
+  if (auto index = getIndex(pos)) {
+    return &grid[*index];
+  }
+
+  auto iter = overflow.find(pos);
+  if (iter != overflow.end()) {
+    return &iter->second;
+  }
+
+  return nullptr;
+}
+
+const Tilemap::Chunk& Tilemap::Chunks::at(Vec2s pos) const {
+  if (const Chunk* chunk = find(pos)) {
+    return *chunk;
+  }
+  throw std::out_of_range("no chunk at requested position");
+}
+
+Tilemap::Chunk& Tilemap::Chunks::operator [](Vec2s pos) {
+  if (auto index = getIndex(pos)) {
+    return grid[*index];
+  }
+  return overflow[pos];
+}
+
+void Tilemap::Chunks::erase(Vec2s pos) {
+  if (auto index = getIndex(pos)) {
+    grid[*index] = Chunk();
+  }
+  else {
+    overflow.erase(pos);
+  }
+}
+
+Tilemap::Chunk* Tilemap::Chunks::find(Vec2s pos) {
+  return const_cast<Chunk*>(static_cast<const Chunks*>(this)->find(pos));
+}
+
+Tilemap::Chunk& Tilemap::Chunks::at(Vec2s pos) {
+  return const_cast<Chunk&>(static_cast<const Chunks*>(this)->at(pos));
+}
+// end Tilemap::Chunks
+
 // begin Tilemap
+static Rect<int> toChunkBounds(Rect<int> bounds) {
+  Vec2i begin = Vec2i(util::absdiv(bounds.x, 16), util::absdiv(bounds.y, 16));
+  Vec2i end = Vec2i(
+    util::absdiv(bounds.x + bounds.width + 15, 16),
+    util::absdiv(bounds.y + bounds.height + 15, 16)
+  );
+  return Rect<int>(begin, end - begin);
+}
+
+Tilemap::Tilemap() {}
+
+Tilemap::Tilemap(const TileDefs& tiledefs_new) : tiledefs(&tiledefs_new) {}
+
+const TileDefs* Tilemap::getTileDefs() const {
+  return tiledefs;
+}
+
+void Tilemap::setTileDefs(const TileDefs& tiledefs_new) {
+  tiledefs = &tiledefs_new;
+}
+
 const Tilemap::Layers& Tilemap::getLayers() const {
   return layers;
 }
 
+std::optional<Rect<int>> Tilemap::getBounds() const {
+  return bounds;
+}
+
+void Tilemap::setBounds(Rect<int> bounds_new) {
+  bounds = bounds_new;
+
+  for (auto& iter : layers) {
+    Chunks chunks(toChunkBounds(*bounds));
+    iter.second.forEach([&chunks](Vec2s pos, Chunk& chunk) {
+      chunks[pos] = std::move(chunk);
+    });
+    iter.second = std::move(chunks);
+  }
+}
+
 const Tilemap::Chunks& Tilemap::getChunks(int layer) const {
   return layers.at(layer);
 }
 
+Tilemap::Chunks& Tilemap::getOrCreateChunks(int layer) {
+  auto iter = layers.find(layer);
+  if (iter == layers.end()) {
+    iter = bounds
+    ? layers.emplace(layer, Chunks(toChunkBounds(*bounds))).first
+    : layers.emplace(layer, Chunks()).first;
+  }
+  return iter->second;
+}
+
 void Tilemap::setChunks(int layer, const Chunks& chunks) {
   layers[layer] = chunks;
 }
 
+void Tilemap::setChunk(int layer, Vec2s pos, Chunk chunk) {
+  Chunk& target = getOrCreateChunks(layer)[pos];
+  chunk.dirty = target.dirty;
+  target = std::move(chunk);
+  markDirty(layer, pos, target);
+}
+
+void Tilemap::resetChunk(int layer, Vec2s pos) {
+  auto iter = layers.find(layer);
+  if (iter == layers.end()) {
+    return;
+  }
+
+  if (Chunk* chunk = iter->second.find(pos)) {
+    bool dirty = chunk->dirty;
+    iter->second.erase(pos);
+    if (Chunk* reset = iter->second.find(pos)) {
+      reset->dirty = dirty;
+      markDirty(layer, pos, *reset);
+    }
+    else if (not dirty) {
+      // overflow chunks are gone entirely, but whatever drew them must know
+      dirty_chunks.push_back(ChunkRef {.layer = layer, .pos = pos});
+    }
+  }
+}
+
+void Tilemap::markDirty(int layer, Vec2s pos, Chunk& chunk) {
+  if (not chunk.dirty) {
+    chunk.dirty = true;
+    dirty_chunks.push_back(ChunkRef {.layer = layer, .pos = pos});
+  }
+}
+
 const Tilemap::Chunk& Tilemap::getChunkAt(int layer, int x, int y) const {
   Vec2s chunk_pos = getChunkPos(x, y);
   return getChunks(layer).at(chunk_pos);
@@ -39,27 +393,87 @@ const Tilemap::Chunk& Tilemap::getChunkAt(Tile tile) const {
   return getChunkAt(tile.layer, tile.pos.x, tile.pos.y);
 }
 
-TileType Tilemap::getTile(int layer, int x, int y) const {
+TileID Tilemap::getTile(int layer, int x, int y) const {
   Vec2s chunk_pos = getChunkPos(x, y);
   Vec2z local_pos = getLocalPos(x, y);
-  const auto& chunks = getChunks(layer);
-  if (chunks.find(chunk_pos) != chunks.end()) {
-    return getChunkAt(layer, x, y)[local_pos.y][local_pos.x];
+  auto layer_iter = layers.find(layer);
+  if (layer_iter != layers.end()) {
+    if (const Chunk* chunk = layer_iter->second.find(chunk_pos)) {
+      return chunk->getTile(local_pos.x, local_pos.y);
+    }
   }
   return notile;
 }
 
-TileType Tilemap::getTile(Tile tile) const {
+TileID Tilemap::getTile(Tile tile) const {
   return getTile(tile.layer, tile.pos.x, tile.pos.y);
 }
 
-void Tilemap::setTile(int layer, int x, int y, TileType tile_type) {
+void Tilemap::setTile(int layer, int x, int y, TileID tile_id) {
+  Vec2s chunk_pos = getChunkPos(x, y);
   Vec2z local_pos = getLocalPos(x, y);
-  layers[layer][getChunkPos(x, y)][local_pos.y][local_pos.x] = tile_type;
+  Chunk& chunk = getOrCreateChunks(layer)[chunk_pos];
+
+  TileID old_tile = chunk.getTile(local_pos.x, local_pos.y);
+  bool changed = chunk.setEntry(local_pos.x, local_pos.y, Chunk::Entry {
+    .tile = tile_id,
+    .collision = tiledefs
+    ? tiledefs->getTileDef(tile_id).getCollisionType()
+    : TileDef::CollisionType::NONE
+  });
+
+  if (changed) {
+    journal.push_back(TileChange {
+      .tile = Tile(layer, x, y),
+      .old_tile = old_tile,
+      .new_tile = tile_id
+    });
+    markDirty(layer, chunk_pos, chunk);
+  }
+}
+
+void Tilemap::setTile(Tile tile, TileID tile_id) {
+  setTile(tile.layer, tile.pos.x, tile.pos.y, tile_id);
+}
+
+void Tilemap::compact() {
+  for (auto& iter : layers) {
+    iter.second.forEach([](Vec2s, Chunk& chunk) {
+      chunk.compact();
+    });
+  }
+}
+
+const std::vector<TileChange>& Tilemap::getJournal() const {
+  return journal;
+}
+
+void Tilemap::clearJournal() {
+  journal.clear();
+}
+
+const std::vector<ChunkRef>& Tilemap::getDirtyChunks() const {
+  return dirty_chunks;
+}
+
+void Tilemap::clearDirtyChunks() {
+  drainDirtyChunks([](const ChunkRef&) {});
+}
+
+TileDef::CollisionType Tilemap::getCollisionType(int layer, int x, int y) const {
+  Vec2s chunk_pos = getChunkPos(x, y);
+  Vec2z local_pos = getLocalPos(x, y);
+  auto layer_iter = layers.find(layer);
+  if (layer_iter != layers.end()) {
+    if (const Chunk* chunk = layer_iter->second.find(chunk_pos)) {
+      return chunk->getCollisionType(local_pos.x, local_pos.y);
+    }
+  }
+  return TileDef::CollisionType::NONE;
 }
 
-void Tilemap::setTile(Tile tile, TileType tile_type) {
-  setTile(tile.layer, tile.pos.x, tile.pos.y, tile_type);
+TileDef::CollisionType Tilemap::getCollisionType(Tile tile) const {
+  return getCollisionType(tile.layer, tile.pos.x, tile.pos.y);
 }
 
 // mutable accessors
@@ -14,7 +14,8 @@
 #include <algorithm>
 #include <exception>
 #include <optional>
-#include <unordered_set>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <cmath>
@@ -23,7 +24,8 @@ namespace kme {
 using namespace vec2_aliases;
 
 // begin Subworld
-Subworld::Subworld(BaseGame* basegame_new, Gameplay* gameplay_new) {
+Subworld::Subworld(BaseGame* basegame_new, Gameplay* gameplay_new)
+: broadphase(Broadphase::create(Broadphase::Type::GRID)) {
   basegame = basegame_new;
   gameplay = gameplay_new;
 }
@@ -34,14 +36,17 @@ EntityRegistry& Subworld::getEntities() {
   return const_cast<EntityRegistry&>(static_cast<const Subworld*>(this)->getEntities());
 }
 
-void Subworld::setEntities(EntityData entity_data_new) { entity_data = entity_data_new; }
+void Subworld::setEntities(EntityData entity_data_new) { entity_data = std::move(entity_data_new); }
 const Tilemap& Subworld::getTilemap() const { return tilemap; }
-void Subworld::setTilemap(Tilemap tilemap_new) { tilemap = tilemap_new; }
+void Subworld::setTilemap(Tilemap tilemap_new) { tilemap = std::move(tilemap_new); }
 
 Tilemap& Subworld::getTilemap() {
   return const_cast<Tilemap&>(static_cast<const Subworld*>(this)->getTilemap());
 }
 
+std::shared_ptr<ChunkStreamer> Subworld::getChunkStreamer() const { return streamer; }
+void Subworld::setChunkStreamer(std::shared_ptr<ChunkStreamer> streamer_new) { streamer = std::move(streamer_new); }
+
 Rect<int> Subworld::getBounds() const { return bounds; }
 void Subworld::setBounds(Rect<int> bounds_new) { bounds = bounds_new; }
 void Subworld::setBounds(int x, int y, int width, int height) { setBounds(Rect<int>(x, y, width, height)); }
@@ -56,8 +61,16 @@ bool Subworld::hasWater() const { return water_height.has_value(); }
 void Subworld::setWaterHeight(int height) { water_height = height; }
 void Subworld::unsetWaterHeight() { water_height = std::nullopt; }
 
+Broadphase::Type Subworld::getBroadphaseType() const { return broadphase->getType(); }
+
+void Subworld::setBroadphaseType(Broadphase::Type type) {
+  if (type != broadphase->getType()) {
+    broadphase = Broadphase::create(type);
+  }
+}
+
 std::string Subworld::getTheme() const { return theme; }
-void Subworld::setTheme(std::string theme_new) { theme = theme_new; }
+void Subworld::setTheme(std::string theme_new) { theme = std::move(theme_new); }
 
 void Subworld::loadEntities() {
   for (std::size_t i = 0; i < entity_data.types.size(); ++i) {
@@ -66,6 +79,87 @@ void Subworld::loadEntities() {
     auto spawner = basegame->getSpawner(entities, entity_type);
     spawner(entity_pos);
   }
+  render_index_stale = true;
+}
+
+// Render state label for a state and powerup, like "WALK" or "WALK.BIG".
+// Every combination is joined once up front, so ticks never build strings.
+static const std::string& getRenderLabel(EState state, Powerup powerup) {
+  constexpr std::size_t state_count = static_cast<std::size_t>(EState::SWIM) + 1;
+  constexpr std::size_t powerup_count = static_cast<std::size_t>(Powerup::HAMMER) + 1;
+
+  static const std::vector<std::string> labels = [] {
+    std::vector<std::string> result;
+    result.reserve(state_count * powerup_count);
+    for (std::size_t i = 0; i < state_count; ++i)
+    for (std::size_t j = 0; j < powerup_count; ++j) {
+      std::string label(getStateName(static_cast<EState>(i)));
+      if (static_cast<Powerup>(j) != Powerup::NONE) {
+        label = util::join({label, std::string(getPowerupName(static_cast<Powerup>(j)))}, ".");
+      }
+      result.push_back(std::move(label));
+    }
+    return result;
+  }();
+
+  return labels[static_cast<std::size_t>(state) * powerup_count + static_cast<std::size_t>(powerup)];
+}
+
+// world space bounds of a sprite drawn the way Gameplay::drawEntities does
+static Rect<float> getSpriteAABB(const RenderFrame& frame, Vec2f pos, Vec2f scale) {
+  const Vec2f size = Vec2f(frame.cliprect.width, frame.cliprect.height);
+  const Vec2f offset = Vec2f(scale.x * frame.offset.x, scale.y * (frame.offset.y + size.y));
+  const Vec2f begin = Vec2f(pos.x * 16.f, -pos.y * 16.f) - offset;
+  const Vec2f end = begin + Vec2f(scale.x * size.x, scale.y * size.y);
+  const Vec2f min = Vec2f(std::min(begin.x, end.x), std::min(begin.y, end.y));
+  const Vec2f max = Vec2f(std::max(begin.x, end.x), std::max(begin.y, end.y));
+  // pad by a pixel for rounding, and flip back to y up
+  return Rect<float>(
+    (min.x - 1.f) / 16.f, -(max.y + 1.f) / 16.f,
+    (max.x - min.x + 2.f) / 16.f, (max.y - min.y + 2.f) / 16.f
+  );
+}
+
+const SpatialGrid& Subworld::getRenderIndex() {
+  if (not render_index_stale) {
+    return render_index;
+  }
+
+  render_index.clear();
+  const EntityDefs& entity_defs = basegame->entity_data;
+  auto view = entities.view<CInfo, CPosition, CRender>();
+  auto direction_view = entities.view<CDirection>();
+  for (auto entity : view) {
+    const auto& info = view.get<CInfo>(entity);
+    const auto& render = view.get<CRender>(entity);
+    const auto& frame = entity_defs.getRenderStates(info.type).getFrame(render.state);
+    if (frame.texture == "") {
+      continue;
+    }
+
+    Sign direction = Sign::PLUS;
+    if (direction_view.contains(entity)) {
+      direction = direction_view.get<CDirection>(entity).value;
+    }
+    const Vec2f scale = Vec2f(direction * render.scale.x, render.scale.y);
+
+    // cover the whole move this tick, since drawing interpolates along it
+    const Vec2f& pos = view.get<CPosition>(entity).value;
+    Rect<float> aabb = getSpriteAABB(frame, pos, scale);
+    if (render.pos_old) {
+      const Rect<float> aabb_old = getSpriteAABB(frame, *render.pos_old, scale);
+      const Vec2f min = Vec2f(std::min(aabb.x, aabb_old.x), std::min(aabb.y, aabb_old.y));
+      const Vec2f max = Vec2f(
+        std::max(aabb.x + aabb.width, aabb_old.x + aabb_old.width),
+        std::max(aabb.y + aabb.height, aabb_old.y + aabb_old.height)
+      );
+      aabb = Rect<float>(min, max - min);
+    }
+    render_index.insert(entity, aabb);
+  }
+
+  render_index_stale = false;
+  return render_index;
 }
 
 // begin ugly
@@ -78,6 +172,27 @@ static Rect<int> toRange(Rect<float> aabb) {
 // end ugly
 
 void Subworld::update(float delta) {
+  // page in chunks around the camera and everything that collides; this also
+  // reads the last tick's journal to keep edited chunks around
+  if (streamer) {
+    stream_focus.clear();
+    if (entities.valid(camera)) {
+      const auto& pos = entities.get<CPosition>(camera).value;
+      stream_focus.push_back(entities.get<CCollision>(camera).hitbox.toAABB(pos));
+    }
+    auto stream_view = entities.view<CPosition, CCollision>();
+    for (auto entity : stream_view) {
+      if (entity != camera) {
+        const auto& pos = stream_view.get<CPosition>(entity).value;
+        stream_focus.push_back(stream_view.get<CCollision>(entity).hitbox.toAABB(pos));
+      }
+    }
+    streamer->update(tilemap, stream_focus);
+  }
+
+  // the tilemap journal only covers the current tick
+  tilemap.clearJournal();
+
   // update timers
   auto timer_view = entities.view<CTimers>();
   for (auto entity : timer_view) {
@@ -119,6 +234,12 @@ void Subworld::update(float delta) {
     }
   }
 
+  // drawing interpolates from here to wherever this tick leaves entities
+  auto interp_view = entities.view<CPosition, CRender>();
+  for (auto entity : interp_view) {
+    interp_view.get<CRender>(entity).pos_old = interp_view.get<CPosition>(entity).value;
+  }
+
   // update render timer
   auto render_view = entities.view<CRender>();
   for (auto entity : render_view) {
@@ -400,6 +521,18 @@ void Subworld::update(float delta) {
     coll.tiles.clear();
   }
 
+  // entity collisions are looked up in a broadphase kept in step with every move
+  broadphase_items.clear();
+  auto broadphase_view = entities.view<CFlags, CPosition, CCollision>();
+  for (auto entity : broadphase_view) {
+    const auto& pos = broadphase_view.get<CPosition>(entity).value;
+    broadphase_items.push_back(Broadphase::Item {
+      .entity = entity,
+      .aabb = broadphase_view.get<CCollision>(entity).hitbox.toAABB(pos)
+    });
+  }
+  broadphase->rebuild(broadphase_items);
+
   // movement code
   auto move_view = entities.view<CFlags, CPosition, CVelocity>();
   //auto collision_view = entities.view<CCollision>();
@@ -447,6 +580,7 @@ void Subworld::update(float delta) {
       checkEntityCollisions(entity);
 
       handleWorldCollisions(entity);
+      updateBroadphase(entity);
       handleEntityCollisions(entity);
     }
     else {
@@ -541,18 +675,17 @@ void Subworld::update(float delta) {
 
     auto& states = basegame->entity_data.getRenderStates(info.type);
 
-    std::string label = getStateName(state).data();
+    Powerup powerup = Powerup::NONE;
     if (powerup_view.contains(entity)) {
-      auto& powerup = powerup_view.get<CPowerup>(entity).value;
-      if (powerup != Powerup::NONE) {
-        label = util::join({label, getPowerupName(powerup).data()}, ".");
-      }
+      powerup = powerup_view.get<CPowerup>(entity).value;
     }
 
+    const std::string& label = getRenderLabel(state, powerup);
     render.state.setState(label, states.getFrameOffset(label, render.time));
   }
 
   consumeEvents();
+  render_index_stale = true;
 }
 // end Subworld
 
@@ -565,15 +698,15 @@ void Subworld::genEvent(EventType type, Event event) {
       auto world_coll = std::get<WorldCollision>(coll_event.collision);
       auto& coll = entities.get<CCollision>(world_coll.entity);
       coll.tiles.insert(world_coll.tile);
-      world_collisions.insert(world_coll);
+      world_collisions.push(world_coll);
       break;
     }
     case CollisionEvent::Type::ENTITY:
       auto ent_coll = std::get<EntityCollision>(coll_event.collision);
       auto ent_coll_reverse = ent_coll;
       std::swap(ent_coll_reverse.entity1, ent_coll_reverse.entity2);
-      entity_collisions.insert(ent_coll);
-      entity_collisions.insert(ent_coll_reverse);
+      entity_collisions.push(ent_coll);
+      entity_collisions.push(ent_coll_reverse);
       break;
     }
     break;
@@ -600,9 +733,6 @@ void Subworld::genCollisionEvent(Entity entity1, Entity entity2) {
 }
 
 void Subworld::consumeEvents() {
-  for (auto event : world_collisions) {}
-  for (auto event : entity_collisions) {}
-
   world_collisions.clear();
   entity_collisions.clear();
 }
@@ -615,23 +745,12 @@ void Subworld::checkWorldCollisions(Entity entity) {
   if (~flags & EFlags::NOCLIP) {
     Rect<float> ent_aabb = coll.hitbox.toAABB(pos);
     Rect<int> range = toRange(ent_aabb);
-    const auto& layers = tilemap.getLayers();
-    for (auto iter = layers.begin(); iter != layers.end(); ++iter)
-    for (int y = range.y; y < range.y + range.height; ++y)
-    for (int x = range.x; x < range.x + range.width;  ++x) {
-      Tile tile(iter->first, x, y);
-      TileType tile_type = tilemap.getTile(tile);
-      Rect<float> tile_aabb = Rect<float>(x, y, 1.f, 1.f);
-      switch (basegame->level_tile_data.getTileDef(tile_type).getCollisionType()) {
-      default:
-        if (geo::intersects(ent_aabb, tile_aabb)) {
-          genCollisionEvent(entity, tile);
-        }
-        break;
-      case TileDef::CollisionType::NONE:
-        break;
+    tilemap.forEachCollision(range, [&](Tile tile, TileDef::CollisionType) {
+      Rect<float> tile_aabb = Rect<float>(tile.pos.x, tile.pos.y, 1.f, 1.f);
+      if (geo::intersects(ent_aabb, tile_aabb)) {
+        genCollisionEvent(entity, tile);
       }
-    }
+    });
   }
 }
 
@@ -643,6 +762,8 @@ void Subworld::handleWorldCollisions(Entity entity) {
 
   Vec2f pos_old = coll.pos_old;
 
+  const auto& tiledefs = basegame->level_tile_data;
+
   Vec2f best_move;
   Vec2f best_push;
 
@@ -655,15 +776,13 @@ void Subworld::handleWorldCollisions(Entity entity) {
 
   for (const auto& tile : coll.tiles) {
     Vec2f pos_new = Vec2f(pos.x, pos_old.y);
-    auto tile_type = tilemap.getTile(tile);
-    TileDef tile_data = basegame->level_tile_data.getTileDef(tile_type);
     Rect<float> ent_aabb = coll.hitbox.toAABB(pos_new);
     Rect<float> tile_aabb = Rect<float>(tile.pos.x, tile.pos.y, 1.f, 1.f);
     Vec2f ent_midpoint = geo::midpoint(ent_aabb);
     Vec2f tile_midpoint = geo::midpoint(tile_aabb);
     if (geo::intersects(ent_aabb, tile_aabb)) {
       auto collision = ent_aabb & tile_aabb;
-      switch (tile_data.getCollisionType()) {
+      switch (tilemap.getCollisionType(tile)) {
       case TileDef::CollisionType::SOLID:
         if (collision.height > 3.f / 16.f) {
           if (ent_midpoint.x > tile_midpoint.x) {
@@ -682,36 +801,21 @@ void Subworld::handleWorldCollisions(Entity entity) {
 
   for (const auto& tile : coll.tiles) {
     Vec2f pos_new = Vec2f(pos.x + best_move.x, pos.y);
-    TileType tile_type = tilemap.getTile(tile);
-    TileDef tiledef = basegame->level_tile_data.getTileDef(tile_type);
+    const TileDef& tiledef = tiledefs.getTileDef(tilemap.getTile(tile));
     Rect<float> ent_aabb = coll.hitbox.toAABB(pos_new);
     Rect<float> tile_aabb = Rect<float>(tile.pos.x, tile.pos.y, 1.f, 1.f);
     Vec2f ent_midpoint = geo::midpoint(ent_aabb);
     Vec2f tile_midpoint = geo::midpoint(tile_aabb);
     if (geo::intersects(ent_aabb, tile_aabb)) {
       auto collision = ent_aabb & tile_aabb;
-      switch (tiledef.getCollisionType()) {
+      switch (tilemap.getCollisionType(tile)) {
       case TileDef::CollisionType::SOLID:
         if (ent_midpoint.y > tile_midpoint.y) {
           if (collision.width > 3.f / 16.f) {
             best_move.y = collision.height;
 
             if (ground_type != GroundType::SOLID) {
-              // FIXME please
-              if (tile_type == "WoodFloorSnow_0"
-              or  tile_type == "WoodFloorSnow_1"
-              or  tile_type == "WoodFloorSnow_2"
-              or  tile_type == "WoodFloorSnow_9"
-              or  tile_type == "WoodFloorSnow_12"
-              or  tile_type == "WoodFloorSnow_13"
-              or  tile_type == "WoodFloorSnow_14"
-              or  tile_type == "IceBlock"
-              or  tile_type == "IceBlockCoin"
-              or  tile_type == "IceBlockMuncher"
-              or  tile_type == "IceBlockBig_0"
-              or  tile_type == "IceBlockBig_1"
-              or  tile_type == "IceBlockBig_2"
-              or  tile_type == "IceBlockBig_3") {
+              if (tiledef.hasFlag(TileDef::Flags::SLIPPERY)) {
                 ground_type = GroundType::ICE;
               }
             }
@@ -725,8 +829,7 @@ void Subworld::handleWorldCollisions(Entity entity) {
             best_move.y = -collision.height;
 
             if (vel.y > 0.f) {
-              if (tile_type == "BrickGold"
-              or  tile_type == "QuestionBlock") {
+              if (tiledef.hasFlag(TileDef::Flags::BUMPABLE)) {
                 itemblocks_hit.push_back(tile);
               }
             }
@@ -752,14 +855,13 @@ void Subworld::handleWorldCollisions(Entity entity) {
 
   for (const auto& tile : coll.tiles) {
     Vec2f pos_new = pos + best_move;
-    TileType tile_type = tilemap.getTile(tile);
-    TileDef tile_data = basegame->level_tile_data.getTileDef(tile_type);
+    const TileDef& tiledef = tiledefs.getTileDef(tilemap.getTile(tile));
     Rect<float> ent_aabb = coll.hitbox.toAABB(pos_new);
     Rect<float> tile_aabb = Rect<float>(tile.pos.x, tile.pos.y, 1.f, 1.f);
-    switch (tile_data.getCollisionType()) {
+    switch (tilemap.getCollisionType(tile)) {
     case TileDef::CollisionType::NONSOLID:
       if (geo::intersects(ent_aabb, tile_aabb)) {
-        if (tile_type == "CoinGold") {
+        if (tiledef.hasFlag(TileDef::Flags::COIN)) {
           coins_collected.push_back(tile);
         }
       }
@@ -835,7 +937,7 @@ void Subworld::handleWorldCollisions(Entity entity) {
   if (entity == player) {
     for (auto& tile : coins_collected) {
       basegame->addCoins(1);
-      tilemap.setTile(tile, "");
+      tilemap.setTile(tile, Tilemap::notile);
       gameplay->playSound("coin");
     }
 
@@ -848,21 +950,22 @@ void Subworld::handleWorldCollisions(Entity entity) {
         }
       );
       Tile& tile = itemblocks_hit[0];
-      TileType tile_type = tilemap.getTile(tile);
-      if (tile_type == "BrickGold") {
-        vel.y += -7.5f;
+      const TileDef& tiledef = tiledefs.getTileDef(tilemap.getTile(tile));
+      vel.y += -7.5f;
+      if (tiledef.hasFlag(TileDef::Flags::BUMP_COIN)) {
+        basegame->addCoins(1);
+        gameplay->playSound("coin");
+      }
+      if (tiledef.hasFlag(TileDef::Flags::TRANSFORMS)) {
+        tilemap.setTile(tile, tiledef.getTransformTarget());
+      }
+      else if (tiledef.hasFlag(TileDef::Flags::BREAKABLE)) {
         auto& powerup = entities.get<CPowerup>(entity).value;
         if (getPowerupTier(powerup) > 0) {
-          tilemap.setTile(tile, "");
+          tilemap.setTile(tile, Tilemap::notile);
           gameplay->playSound("smash");
         }
       }
-      else if (tile_type == "QuestionBlock") {
-        vel.y += -7.5f;
-        basegame->addCoins(1);
-        tilemap.setTile(tile, "EmptyBlock");
-        gameplay->playSound("coin");
-      }
     }
   }
 
@@ -892,7 +995,17 @@ void Subworld::handleWorldCollisions(Entity entity) {
   }
 }
 
+void Subworld::updateBroadphase(Entity entity) {
+  if (broadphase->contains(entity)) {
+    const auto& pos = entities.get<CPosition>(entity).value;
+    broadphase->update(entity, entities.get<CCollision>(entity).hitbox.toAABB(pos));
+  }
+}
+
 void Subworld::checkEntityCollisions(Entity entity1) {
+  // the entity has just moved, so it must be current before querying
+  updateBroadphase(entity1);
+
   auto& flags1 = entities.get<CFlags>(entity1).value;
   if (flags1 & EFlags::INTANGIBLE)
     return; // Intangible entities don't collide with other entities
@@ -900,19 +1013,20 @@ void Subworld::checkEntityCollisions(Entity entity1) {
   auto& pos1 = entities.get<CPosition>(entity1).value;
   auto& coll1 = entities.get<CCollision>(entity1);
 
-  auto collision_view = entities.view<CFlags, CPosition, CCollision>();
-  for (auto entity2 : collision_view) {
+  Rect<float> entity1_aabb = coll1.hitbox.toAABB(pos1);
+  broadphase->query(entity1_aabb, collision_candidates);
+  for (const auto& candidate : collision_candidates) {
+    auto entity2 = candidate.entity;
     if (entity1 == entity2)
       continue; // Don't collide with self!
 
-    auto& flags2 = collision_view.get<CFlags>(entity2).value;
+    auto& flags2 = entities.get<CFlags>(entity2).value;
     if (flags2 & EFlags::INTANGIBLE)
       continue;
 
-    auto& pos2 = collision_view.get<CPosition>(entity2).value;
-    auto& coll2 = collision_view.get<CCollision>(entity2);
+    auto& pos2 = entities.get<CPosition>(entity2).value;
+    auto& coll2 = entities.get<CCollision>(entity2);
 
-    Rect<float> entity1_aabb = coll1.hitbox.toAABB(pos1);
     Rect<float> entity2_aabb = coll2.hitbox.toAABB(pos2);
     if (geo::intersects(entity1_aabb, entity2_aabb)) {
       genCollisionEvent(entity1, entity2);
@@ -921,6 +1035,7 @@ void Subworld::checkEntityCollisions(Entity entity1) {
 }
 
 void Subworld::handleEntityCollisions(Entity entity) {
+  entity_collisions.deduplicate();
   for (const auto& collision_event : entity_collisions) {
     auto entity1 = collision_event.entity1;
     auto entity2 = collision_event.entity2;
@@ -978,6 +1093,7 @@ void Subworld::handleEntityCollisions(Entity entity) {
       }
 
       pos1 += best_move;
+      updateBroadphase(entity1);
 
       if (flags1 & EFlags::ENEMY
       or  flags1 & EFlags::POWERUP) {
@@ -1,15 +1,19 @@
 #pragma once
 
 #include "../../math.hpp"
+#include "broadphase.hpp"
+#include "chunkstreamer.hpp"
 #include "collision.hpp"
 #include "entity.hpp"
+#include "eventbuffer.hpp"
+#include "spatialgrid.hpp"
 #include "theme.hpp"
 #include "tilemap.hpp"
 
 #include <map>
+#include <memory>
 #include <optional>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -41,6 +45,10 @@ public:
   Tilemap& getTilemap();
   void setTilemap(Tilemap tilemap);
 
+  // streamed subworlds page their tilemap in around colliders every tick
+  std::shared_ptr<ChunkStreamer> getChunkStreamer() const;
+  void setChunkStreamer(std::shared_ptr<ChunkStreamer> streamer);
+
   Rect<int> getBounds() const;
   void setBounds(int width, int height);
   void setBounds(int x, int y, int width, int height);
@@ -55,11 +63,19 @@ public:
   void setWaterHeight(int height);
   void unsetWaterHeight();
 
+  // how entity collisions find their candidates; the grid by default
+  Broadphase::Type getBroadphaseType() const;
+  void setBroadphaseType(Broadphase::Type type);
+
   std::string getTheme() const;
   void setTheme(std::string theme);
 
   void loadEntities();
 
+  // drawable entities by the world space bounds of their sprites, rebuilt
+  // on first use after each tick
+  const SpatialGrid& getRenderIndex();
+
   void update(float delta);
 
 private:
@@ -73,6 +89,7 @@ private:
   void checkWorldCollisions(Entity entity);
   void handleWorldCollisions(Entity entity);
 
+  void updateBroadphase(Entity entity);
   void checkEntityCollisions(Entity entity);
   void handleEntityCollisions(Entity entity);
 
@@ -89,9 +106,18 @@ private:
 
   EntityRegistry entities;
   Tilemap tilemap;
+  std::shared_ptr<ChunkStreamer> streamer;
+  std::vector<Rect<float>> stream_focus;
+
+  std::unique_ptr<Broadphase> broadphase;
+  std::vector<Broadphase::Item> broadphase_items;
+  std::vector<Broadphase::Item> collision_candidates;
+
+  SpatialGrid render_index;
+  bool render_index_stale = true;
 
-  std::unordered_set<WorldCollision> world_collisions;
-  std::unordered_set<EntityCollision> entity_collisions;
+  EventBuffer<WorldCollision> world_collisions;
+  EventBuffer<EntityCollision> entity_collisions;
 
   Rect<int> bounds;
   float gravity = -60.f;
@@ -11,6 +11,8 @@
 #include "basegame/tilemap.hpp"
 #include "basegame.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <optional>
@@ -29,16 +31,6 @@ Gameplay::Factory Gameplay::create(std::size_t worldnum, std::size_t levelnum) {
 
 Gameplay::Gameplay(BaseState* parent, Engine* engine, std::size_t worldnum, std::size_t levelnum)
 : BaseState(parent, engine), worldnum(worldnum), levelnum(levelnum), level(getBaseGame(), this) {
-  if (engine->getWindow()) {
-    framebuffer.emplace();
-    scene.emplace();
-    hud.emplace();
-
-    framebuffer->create(480, 270);
-    scene->create(480, 270);
-    hud->create(480, 270);
-  }
-
   inputs.actions[Action::UP]       = 0;
   inputs.actions[Action::DOWN]     = 0;
   inputs.actions[Action::LEFT]     = 0;
@@ -89,7 +81,7 @@ bool Gameplay::handleInput(sf::Event::EventType type, const sf::Event& event) {
 }
 
 void Gameplay::enter() {
-  LevelLoader loader(worldnum, levelnum);
+  LevelLoader loader(getBaseGame()->level_tile_data, worldnum, levelnum);
   loader.load(level);
 
   Subworld& subworld = level.getSubworld(current_subworld);
@@ -118,6 +110,7 @@ void Gameplay::exit() {}
 
 void Gameplay::pause() {
   paused = true;
+  interpolating = false;
 }
 
 void Gameplay::resume() {
@@ -133,6 +126,7 @@ void Gameplay::update(float delta) {
     suspended_previous = suspended;
 
     Subworld& subworld = level.getSubworld(current_subworld);
+    interpolating = not suspended;
     if (not suspended) {
       subworld.update(delta);
 
@@ -167,12 +161,21 @@ bool Gameplay::isSuspended() const {
   return suspended;
 }
 
+const RenderStats& Gameplay::getRenderStats() const {
+  return render_stats;
+}
+
 void Gameplay::draw(float delta) {
   if (auto& window = engine->getWindow()) {
+    render_stats.reset();
+
     const Subworld& subworld = level.getSubworld(current_subworld);
     const EntityRegistry& entities = subworld.getEntities();
-    const auto& pos = entities.get<CPosition>(subworld.camera).value;
-    const auto& hitbox = entities.get<CCollision>(subworld.camera).hitbox;
+    // without a tick in progress there is nothing to interpolate towards
+    const float alpha = interpolating ? engine->getTickAlpha() : 1.f;
+    const auto& coll = entities.get<CCollision>(subworld.camera);
+    const auto pos = interpolate(coll.pos_old, entities.get<CPosition>(subworld.camera).value, alpha);
+    const auto& hitbox = coll.hitbox;
     const Rect<float> aabb = [pos, hitbox] {
       auto result = hitbox.toAABB(pos);
       // snap camera to integer coordinates
@@ -181,105 +184,93 @@ void Gameplay::draw(float delta) {
     }();
 
     // set view to camera
-    sf::View view = scene->getView();
+    sf::View view = window->getCanvasView();
     view.setCenter(toScreen(geo::midpoint(aabb)));
-    scene->setView(view);
+    window->setView(view);
 
     const auto& theme = getBaseGame()->themes.at(subworld.getTheme());
-    drawBackground(theme.background);
+    drawBackground(*window, theme.background);
     for (const auto& it : theme.layers) {
-      drawBackground(it.second);
+      drawBackground(*window, it.second, aabb);
     }
 
-    drawTiles();
-    drawEntities();
+    getBaseGame()->level_tile_data.updateFrames(rendertime);
+    drawTiles(*window);
+    drawEntities(*window, aabb, alpha);
     if (auto water = subworld.getWaterHeight()) {
-      drawWater(*water);
+      drawWater(*window, *water, aabb);
     }
-    drawHUD();
 
-    scene->display();
-    hud->display();
-
-    framebuffer->draw(sf::Sprite(scene->getTexture()));
-    framebuffer->draw(sf::Sprite(hud->getTexture()));
-    framebuffer->display();
-
-    window->getFramebuffer()->draw(sf::Sprite(framebuffer->getTexture()));
+    window->setView(window->getCanvasView());
+    drawHUD(*window);
   }
 
   rendertime += delta;
 }
 
-void Gameplay::drawBackground(Color color) {
-  scene->clear(color);
+void Gameplay::drawBackground(sf::RenderTarget& target, Color color) {
+  // fill the view rather than clearing, which would cover the letterbox too
+  const sf::View& view = target.getView();
+  const Vec2f begin = Vec2f(view.getCenter()) - Vec2f(view.getSize()) / 2.f;
+  const Vec2f end = begin + view.getSize();
+  const sf::Vertex quad[4] = {
+    sf::Vertex(Vec2f(begin.x, begin.y), color),
+    sf::Vertex(Vec2f(end.x, begin.y), color),
+    sf::Vertex(Vec2f(end.x, end.y), color),
+    sf::Vertex(Vec2f(begin.x, end.y), color)
+  };
+  target.draw(quad, 4, sf::Quads);
+  render_stats.count(4, nullptr);
 }
 
-void Gameplay::drawBackground(Layer layer) {
-  drawBackground(layer.background, layer.offset, layer.parallax, layer.repeat_y);
+void Gameplay::drawBackground(sf::RenderTarget& target, const Layer& layer,
+                              Rect<float> camera) {
+  drawBackground(target, layer.background, layer.offset, layer.parallax, camera, layer.repeat_y);
 }
 
-// NOTE: this function could use a few improvements
-void Gameplay::drawBackground(std::string name, Vec2f offset, Vec2f parallax,
-                              bool tile_vertically) {
+// The background texture is repeating, so each layer is a single quad over the
+// view whose texture rectangle is shifted by the layer's scroll position.
+void Gameplay::drawBackground(sf::RenderTarget& target, std::string name,
+                              Vec2f offset, Vec2f parallax,
+                              Rect<float> camera, bool tile_vertically) {
   const RenderFrames& background = getBaseGame()->backgrounds.at(name);
   const RenderFrame& frame = background.getFrame(background.getFrameOffset(rendertime));
   const sf::Texture& texture = gfx.getTexture(frame.texture);
   Vec2f size = static_cast<sf::Vector2f>(texture.getSize());
-  Vec2f tiling_ratio = Vec2f(480.f / size.x, 270.f / size.y);
-
-  const Subworld& subworld = level.getSubworld(current_subworld);
-  const EntityRegistry& entities = subworld.getEntities();
-  const auto& pos = entities.get<CPosition>(subworld.camera).value;
-  const auto& hitbox = entities.get<CCollision>(subworld.camera).hitbox;
-  const auto aabb = [pos, hitbox]() {
-    auto result = hitbox.toAABB(pos);
-    // snap camera to integer coordinates
-    result.pos = fromScreen(fp::map(util::round, toScreen(result.pos)));
-    return result;
-  }();
 
-  Vec2f origin = aabb.pos;
-  Vec2f bg_begin = origin;
-  bg_begin.x = bg_begin.x * (1.f - parallax.x);
-  bg_begin.y = bg_begin.y * (1.f - parallax.y);
-  Vec2f bg_end = bg_begin + aabb.size;
-  bg_begin.x = bg_begin.x * 16.f / 480.f * tiling_ratio.x;
-  bg_begin.y = bg_begin.y * 16.f / 270.f * tiling_ratio.y;
-  bg_end.x = bg_end.x * 16.f / 480.f * tiling_ratio.x;
-  bg_end.y = bg_end.y * 16.f / 270.f * tiling_ratio.y;
-
-  if (tile_vertically == true) {
-    Vec2f begin(
-      std::floor(bg_begin.x + offset.x / size.x),
-      std::floor(bg_begin.y + offset.y / size.y)
-    );
-    Vec2f end(
-      std::floor(bg_end.x + offset.x / size.x) + 1.f,
-      std::floor(bg_end.y + offset.y / size.y) + 1.f
-    );
-    for (float y = begin.y; y < end.y; y += 1.f)
-    for (float x = begin.x; x < end.x; x += 1.f) {
-      sf::Sprite sprite(texture);
-      Vec2f pos = Vec2f((origin.x * parallax.x * 16.f) + x * size.x,
-                      -((origin.y * parallax.y * 16.f) + y * size.y + size.y));
-      pos -= offset;
-      sprite.setPosition(pos);
-      scene->draw(sprite);
+  // screen position of the top left corner of one repetition of the image
+  Vec2f phase = Vec2f(camera.x * parallax.x * 16.f,
+                    -(camera.y * parallax.y * 16.f + size.y));
+  phase -= offset;
+  // snap to whole pixels, as the scene is drawn at canvas resolution
+  phase = fp::map(util::round, phase);
+
+  Vec2f begin = toScreen(Vec2f(camera.x, camera.y + camera.height));
+  Vec2f end = toScreen(Vec2f(camera.x + camera.width, camera.y));
+  if (not tile_vertically) {
+    begin.y = std::max(begin.y, phase.y);
+    end.y = std::min(end.y, phase.y + size.y);
+    if (begin.y >= end.y) {
+      return;
     }
   }
-  else {
-    float begin = std::floor(bg_begin.x + offset.x / size.x);
-    float end = std::floor(bg_end.x + offset.x / size.x) + 1.f;
-    for (float x = begin; x < end; x += 1.f) {
-      sf::Sprite sprite(texture);
-      Vec2f pos = Vec2f((origin.x * parallax.x * 16.f) + x * size.x,
-                      -((origin.y * parallax.y * 16.f) + size.y));
-      pos -= offset;
-      sprite.setPosition(pos);
-      scene->draw(sprite);
-    }
+
+  // keep texture coordinates near the origin so they don't lose precision
+  Vec2f tex_begin = begin - phase;
+  tex_begin.x -= std::floor(tex_begin.x / size.x) * size.x;
+  if (tile_vertically) {
+    tex_begin.y -= std::floor(tex_begin.y / size.y) * size.y;
   }
+  const Vec2f tex_end = tex_begin + (end - begin);
+
+  const sf::Vertex quad[4] = {
+    sf::Vertex(Vec2f(begin.x, begin.y), Vec2f(tex_begin.x, tex_begin.y)),
+    sf::Vertex(Vec2f(end.x, begin.y), Vec2f(tex_end.x, tex_begin.y)),
+    sf::Vertex(Vec2f(end.x, end.y), Vec2f(tex_end.x, tex_end.y)),
+    sf::Vertex(Vec2f(begin.x, end.y), Vec2f(tex_begin.x, tex_end.y))
+  };
+  target.draw(quad, 4, sf::Quads, sf::RenderStates(&texture));
+  render_stats.count(4, &texture);
 }
 
 // begin ugly
@@ -293,54 +284,136 @@ static Rect<int> viewportFromRegion(Rect<float> region) {
 }
 // end ugly
 
-void Gameplay::drawTile(Vec2f pos, TileType tile_type) {
-  TileDef tiledef = getBaseGame()->level_tile_data.getTileDef(tile_type);
-  std::size_t frame = tiledef.getFrameOffset(rendertime);
-  std::string texture = tiledef.getFrame(frame).texture;
-  if (texture != "") {
-    sf::Sprite sprite(gfx.getTile(texture), tiledef.getFrame(frame).cliprect);
-    sprite.setPosition(toScreen(Vec2f(pos.x, pos.y + 1)));
-    scene->draw(sprite);
+void Gameplay::bakeChunk(ChunkMesh& mesh, Vec2s pos, const Tilemap::Chunk& chunk) {
+  const TileDefs& tiledefs = getBaseGame()->level_tile_data;
+
+  mesh.baked = true;
+  mesh.animated.clear();
+  mesh.batches.clear();
+
+  if (chunk.isUniform() and chunk.getUniform().tile == Tilemap::notile) {
+    return;
   }
-}
 
-void Gameplay::drawChunk(Vec2s pos, const Tilemap::Chunk& chunk) {
   for (std::size_t y = 0; y < 16; ++y)
   for (std::size_t x = 0; x < 16; ++x) {
-    TileType tile_type = chunk.at(y).at(x);
-    drawTile(Vec2f(16 * pos.x + x, 16 * pos.y + y), tile_type);
+    TileID tile_id = chunk.getTile(x, y);
+    if (tile_id == Tilemap::notile) {
+      continue;
+    }
+
+    if (tiledefs.getTileDef(tile_id).getFrameCount() > 1) {
+      auto iter = std::find_if(mesh.animated.begin(), mesh.animated.end(), [tile_id](const auto& item) {
+        return item.first == tile_id;
+      });
+      if (iter == mesh.animated.end()) {
+        mesh.animated.emplace_back(tile_id, tiledefs.getFrameOffset(tile_id));
+      }
+    }
+
+    const RenderFrame& frame = tiledefs.getCurrentFrame(tile_id);
+    if (frame.texture == "") {
+      continue;
+    }
+
+    const sf::Texture* texture = &gfx.getTile(frame.texture);
+    auto batch = std::find_if(mesh.batches.begin(), mesh.batches.end(), [texture](const auto& item) {
+      return item.first == texture;
+    });
+    if (batch == mesh.batches.end()) {
+      batch = mesh.batches.emplace(mesh.batches.end(), texture, sf::VertexArray(sf::Quads));
+    }
+
+    const Vec2f origin = toScreen(Vec2f(16 * pos.x + x, 16 * pos.y + y + 1));
+    const Rect<float> rect(frame.cliprect);
+    const Vec2f corners[4] = {
+      Vec2f(0.f, 0.f), Vec2f(rect.width, 0.f),
+      Vec2f(rect.width, rect.height), Vec2f(0.f, rect.height)
+    };
+    for (const auto& corner : corners) {
+      batch->second.append(sf::Vertex(origin + corner, rect.pos + corner));
+    }
   }
 }
 
-void Gameplay::drawTiles() {
-  const auto& tilemap = level.getSubworld(current_subworld).getTilemap();
+void Gameplay::drawTiles(sf::RenderTarget& target) {
+  const TileDefs& tiledefs = getBaseGame()->level_tile_data;
+  auto& tilemap = level.getSubworld(current_subworld).getTilemap();
   const auto& layers = tilemap.getLayers();
-  const auto& view = scene->getView();
+  const auto& view = target.getView();
   const auto range = [view] {
     const Vec2f size = static_cast<Vec2f>(view.getSize()) / 16.f;
     const Vec2f pos = fromScreen(view.getCenter()) - size / 2.f;
     return Rect<float>(pos / 16.f, size / 16.f);
   }();
+
+  if (chunk_meshes_subworld != current_subworld) {
+    chunk_meshes.clear();
+    chunk_meshes_subworld = current_subworld;
+  }
+  ++frame_count;
+
+  // rebake whatever was edited or streamed since the last frame
+  tilemap.drainDirtyChunks([this](const ChunkRef& ref) {
+    auto iter = chunk_meshes.find(ref);
+    if (iter != chunk_meshes.end()) {
+      iter->second.baked = false;
+    }
+  });
+
   for (auto iter = layers.rbegin(); iter != layers.rend(); ++iter) {
     const auto& chunks = iter->second;
     for (short y = std::floor(range.y); y < std::ceil(range.y + range.height); ++y)
     for (short x = std::floor(range.x); x < std::ceil(range.x + range.width); ++x) {
       Vec2s pos(x, y);
-      const auto& chunks_iter = chunks.find(pos);
-      if (chunks_iter != chunks.end()) {
-        drawChunk(pos, chunks_iter->second);
+      const auto* chunk = chunks.find(pos);
+      if (chunk == nullptr) {
+        continue;
+      }
+
+      ChunkMesh& mesh = chunk_meshes[ChunkRef {.layer = iter->first, .pos = pos}];
+      mesh.last_drawn = frame_count;
+
+      bool stale = not mesh.baked;
+      for (std::size_t i = 0; i < mesh.animated.size() and not stale; ++i) {
+        stale = tiledefs.getFrameOffset(mesh.animated[i].first) != mesh.animated[i].second;
+      }
+      if (stale) {
+        bakeChunk(mesh, pos, *chunk);
+      }
+
+      for (const auto& batch : mesh.batches) {
+        target.draw(batch.second, sf::RenderStates(batch.first));
+        render_stats.count(batch.second.getVertexCount(), batch.first);
+      }
+    }
+  }
+
+  // forget chunks that have scrolled out of view once the cache grows
+  if (chunk_meshes.size() > 1024) {
+    for (auto iter = chunk_meshes.begin(); iter != chunk_meshes.end();) {
+      if (iter->second.last_drawn != frame_count) {
+        iter = chunk_meshes.erase(iter);
+      }
+      else {
+        ++iter;
       }
     }
   }
 }
 
-void Gameplay::drawEntities() {
-  const Subworld& subworld = level.getSubworld(current_subworld);
+void Gameplay::drawEntities(sf::RenderTarget& target, Rect<float> camera, float alpha) {
+  Subworld& subworld = level.getSubworld(current_subworld);
   const EntityDefs& entity_data = getBaseGame()->entity_data;
   const EntityRegistry& entities = subworld.getEntities();
 
-  auto view = entities.view<CInfo, CPosition, CRender>();
-  for (auto entity : view) {
+  // only entities whose sprites can overlap the camera are visited at all
+  const SpatialGrid& index = subworld.getRenderIndex();
+  index.query(camera, visible_entities);
+  render_stats.sprites_culled += index.size() - visible_entities.size();
+
+  for (const auto& item : visible_entities) {
+    const Entity entity = item.entity;
     auto timer_view = entities.view<CTimers>();
     if (timer_view.contains(entity)) {
       const auto& timers = timer_view.get<const CTimers>(entity);
@@ -350,9 +423,10 @@ void Gameplay::drawEntities() {
       }
     }
 
-    const auto& info = view.get<const CInfo>(entity);
-    const auto& pos = view.get<const CPosition>(entity).value;
-    const auto& render = view.get<const CRender>(entity);
+    const auto& info = entities.get<CInfo>(entity);
+    const auto& render = entities.get<CRender>(entity);
+    const auto& pos_new = entities.get<CPosition>(entity).value;
+    const auto pos = interpolate(render.pos_old.value_or(pos_new), pos_new, alpha);
 
     const auto& frame = entity_data.getRenderStates(info.type).getFrame(render.state);
 
@@ -362,9 +436,13 @@ void Gameplay::drawEntities() {
       direction = direction_view.get<const CDirection>(entity).value;
     }
 
-    std::string texture = frame.texture;
-    if (texture != "") {
-      sf::Sprite sprite(gfx.getSprite(texture), frame.cliprect);
+    auto texture = sprite_textures.find(&frame);
+    if (texture == sprite_textures.end()) {
+      texture = sprite_textures.emplace(
+        &frame, frame.texture.empty() ? nullptr : &gfx.getSprite(frame.texture)
+      ).first;
+    }
+    if (texture->second != nullptr) {
       Vec2f scale = Vec2f(direction * render.scale.x, render.scale.y);
       Vec2f offset = Vec2f(
         scale.x * frame.offset.x,
@@ -373,98 +451,131 @@ void Gameplay::drawEntities() {
       Vec2f pos_render = toScreen(pos) - offset;
       pos_render.x = std::floor(pos_render.x + 0.5f);
       pos_render.y = std::floor(pos_render.y + 0.5f);
-      sprite.setPosition(pos_render);
-      sprite.setScale(scale);
-      scene->draw(sprite);
+      sprite_batch.push(*texture->second, frame.cliprect, pos_render, scale);
+      ++render_stats.sprites_drawn;
     }
   }
+
+  sprite_batch.draw(target, &render_stats);
 }
 
 // NOTE: this function needs improvement
-void Gameplay::drawWater(float height) {
-  const Subworld& subworld = level.getSubworld(current_subworld);
-  const EntityRegistry& entities = subworld.getEntities();
-  const auto& pos = entities.get<CPosition>(subworld.camera).value;
-  const auto& hitbox = entities.get<CCollision>(subworld.camera).hitbox;
-
-  const auto aabb = [pos, hitbox]() {
-    auto result = hitbox.toAABB(pos);
-    // snap camera to integer coordinates
-    result.pos = fromScreen(fp::map(util::round, toScreen(result.pos)));
-    return result;
-  }();
-
+// One draw call for the surface, whose columns all sample the same animation
+// frame out of a wider strip, and one for the body below it
+void Gameplay::drawWater(sf::RenderTarget& target, float height, Rect<float> camera) {
   const auto& water_top = gfx.getTexture("water_overlay_top");
   const auto& water = gfx.getTexture("water_overlay");
 
   const int water_top_height = water_top.getSize().y;
 
-  if (height >= aabb.y
-  and height - water_top_height / 16 < aabb.y + aabb.height) {
-    for (int x = aabb.x; x < aabb.x + aabb.width; ++x) {
-      const int offset = rendertime / (8.f / 60.f);
-      sf::Sprite sprite(water_top, Rect<int>((offset % 4) * 16, 0, 16, water_top_height));
-      sprite.setPosition(toScreen(Vec2f(x, height)));
-      scene->draw(sprite);
-    }
+  const int x_begin = std::floor(camera.x);
+  const int columns = std::ceil(camera.x + camera.width - x_begin);
+
+  if (height >= camera.y
+  and height - water_top_height / 16 < camera.y + camera.height) {
+    const int offset = rendertime / (8.f / 60.f);
+    drawRepeated(target, water_top, Rect<int>((offset % 4) * 16, 0, 16, water_top_height),
+                 toScreen(Vec2f(x_begin, height)), Vec2i(columns, 1), Vec2f(16.f, 0.f),
+                 water_vertices, &render_stats);
   }
 
-  for (int y = aabb.y; y < std::min(aabb.y + aabb.height, height - water_top_height / 16); ++y)
-  for (int x = aabb.x; x < aabb.x + aabb.width; ++x) {
-    sf::Sprite sprite(water);
-    sprite.setPosition(toScreen(Vec2f(x, y + 1)));
-    scene->draw(sprite);
+  // one sprite of the whole texture per tile, bottom row first; this is a
+  // single quad as long as the texture is exactly one tile in size
+  const int y_begin = std::floor(camera.y);
+  const float y_end = std::min(camera.y + camera.height, height - water_top_height / 16);
+  const int rows = std::ceil(y_end - y_begin);
+
+  drawRepeated(target, water, Rect<int>(Vec2i(0, 0), static_cast<Vec2i>(Vec2u(water.getSize()))),
+               toScreen(Vec2f(x_begin, y_begin + 1)), Vec2i(columns, rows), Vec2f(16.f, -16.f),
+               water_vertices, &render_stats);
+}
+
+// Recompiles a field's glyphs only when the value it shows has changed
+void Gameplay::updateHUDField(std::size_t field, ULong value,
+                              const std::function<std::string()>& text,
+                              Vec2f origin, TextStyle style) {
+  const Vec2u canvas_size = engine->getWindow()->getCanvasSize();
+  auto& cache = hud_fields[field];
+  if (cache.value == value) {
+    return;
   }
-}
 
-void Gameplay::drawHUD() {
-  hud->clear(Color(0, 0, 0, 0));
+  cache.value = value;
+  cache.vertices.clear();
+  compileText(cache.vertices, canvas_size, text(), origin, style);
+}
 
+void Gameplay::drawHUD(sf::RenderTarget& target) {
   const auto& subworld = level.getSubworld(current_subworld);
   const auto& entities = subworld.getEntities();
 
   const auto& counters = entities.get<CCounters>(subworld.player);
 
-  std::stringstream world;
-  world << util::highASCII("abcd") << worldnum << '-' << levelnum;
+  TextStyle align_left("smb3_sbfont");
+  TextStyle align_right("smb3_sbfont", TextStyle::Flags::ALIGN_RIGHT);
+  TextStyle align_bottom("smb3_sbfont", TextStyle::Flags::ALIGN_BOTTOM);
 
-  std::stringstream p_meter;
+  updateHUDField(HUDField::WORLD, 0, [&] {
+    std::stringstream world;
+    world << util::highASCII("abcd") << worldnum << '-' << levelnum;
+    return world.str();
+  }, Vec2f(16, 16), align_left);
+
+  const UInt lives = getBaseGame()->getLives();
+  updateHUDField(HUDField::LIVES, lives, [&] {
+    std::stringstream mario;
+    mario << util::highASCII("ABx") << std::setw(2) << lives;
+    return mario.str();
+  }, Vec2f(16, 24), align_left);
+
+  const int time = std::ceil(level.timer);
+  updateHUDField(HUDField::TIMER, time, [&] {
+    std::stringstream timer;
+    timer << "@" << std::fixed << std::internal
+             << std::setprecision(0) << std::setw(3) << std::setfill('0')
+             << time;
+    return timer.str();
+  }, Vec2f(48, 16), align_right);
+
+  const UInt coin_count = getBaseGame()->getCoins();
+  updateHUDField(HUDField::COINS, coin_count, [&] {
+    std::stringstream coins;
+    coins << "$" << std::setw(2) << coin_count;
+    return coins.str();
+  }, Vec2f(16, 16), align_right);
+
+  const ULong points = getBaseGame()->getScore();
+  updateHUDField(HUDField::SCORE, points, [&] {
+    std::stringstream score;
+    score << std::internal << std::setw(7) << std::setfill('0') << points;
+    return score.str();
+  }, Vec2f(16, 24), align_right);
+
+  // number of lit arrows, plus whether the P is lit
+  std::size_t arrows = 0;
   for (std::size_t i = 0; i < 6; ++i) {
-    p_meter << (counters.p_meter > i ? util::highASCII('>') : '>');
+    arrows += counters.p_meter > i;
   }
-  if (counters.p_meter > 6.f
-  and std::fmod(rendertime, 0.25f) > 0.125f) {
-    p_meter << util::highASCII("()");
-  }
-  else {
-    p_meter << "()";
+  const bool p_lit = counters.p_meter > 6.f
+                 and std::fmod(rendertime, 0.25f) > 0.125f;
+  updateHUDField(HUDField::P_METER, arrows << 1 | p_lit, [&] {
+    std::stringstream p_meter;
+    for (std::size_t i = 0; i < 6; ++i) {
+      p_meter << (i < arrows ? util::highASCII('>') : '>');
+    }
+    p_meter << (p_lit ? util::highASCII("()") : "()");
+    return p_meter.str();
+  }, Vec2f(64, 6), align_bottom);
+
+  for (const auto& cache : hud_fields) {
+    const sf::Texture& font = gfx.getTexture("smb3_sbfont");
+    target.draw(cache.vertices, sf::RenderStates(&font));
+    render_stats.count(cache.vertices.getVertexCount(), &font);
   }
+}
 
-  std::stringstream coins;
-  coins << "$" << std::setw(2) << getBaseGame()->getCoins();
-
-  std::stringstream mario;
-  mario << util::highASCII("ABx") << std::setw(2) << getBaseGame()->getLives();
-
-  std::stringstream score;
-  score << std::internal << std::setw(7) << std::setfill('0') << getBaseGame()->getScore();
-
-  std::stringstream timer;
-  timer << "@" << std::fixed << std::internal
-           << std::setprecision(0) << std::setw(3) << std::setfill('0')
-           << int(std::ceil(level.timer));
-
-  TextStyle align_left("smb3_sbfont");
-  drawText(*hud, world.str(), Vec2f(16, 16), align_left);
-  drawText(*hud, mario.str(), Vec2f(16, 24), align_left);
-
-  TextStyle align_right("smb3_sbfont", TextStyle::Flags::ALIGN_RIGHT);
-  drawText(*hud, timer.str(), Vec2f(48, 16), align_right);
-  drawText(*hud, coins.str(), Vec2f(16, 16), align_right);
-  drawText(*hud, score.str(), Vec2f(16, 24), align_right);
-
-  TextStyle align_bottom("smb3_sbfont", TextStyle::Flags::ALIGN_BOTTOM);
-  drawText(*hud, p_meter.str(), Vec2f(64, 6), align_bottom);
+Vec2f Gameplay::interpolate(Vec2f pos_old, Vec2f pos, float alpha) {
+  return pos_old + (pos - pos_old) * alpha;
 }
 
 Vec2f Gameplay::fromScreen(Vec2f pos) {
@@ -4,6 +4,7 @@
 #include "../input.hpp"
 #include "../inputhandler.hpp"
 #include "../math.hpp"
+#include "../renderer.hpp"
 #include "../types.hpp"
 #include "basegame/theme.hpp"
 #include "basegame/tilemap.hpp"
@@ -13,8 +14,14 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
 
+#include <array>
+#include <functional>
+#include <map>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <cstddef>
 
@@ -63,20 +70,52 @@ public:
   void unsuspend();
   bool isSuspended() const;
 
+  // counters for the last frame drawn
+  const RenderStats& getRenderStats() const;
+
 private:
+  // Baked quads for one chunk of one layer, one vertex array per texture.
+  // Rebuilt when the tilemap reports the chunk dirty or one of its animated
+  // tiles moves on to another frame.
+  struct ChunkMesh {
+    bool baked = false;
+    std::size_t last_drawn = 0;
+    std::vector<std::pair<TileID, std::size_t>> animated;
+    std::vector<std::pair<const sf::Texture*, sf::VertexArray>> batches;
+  };
+
+  struct HUDField {
+    enum : std::size_t {
+      WORLD, LIVES, TIMER, COINS, SCORE, P_METER,
+      COUNT
+    };
+  };
+
+  // glyphs of one HUD field, compiled for the value they were last built from
+  struct HUDCache {
+    std::optional<ULong> value;
+    sf::VertexArray vertices;
+  };
+
   BaseGame* getBaseGame();
 
-  void drawBackground(Color color);
-  void drawBackground(Layer layer);
+  void drawBackground(sf::RenderTarget& target, Color color);
+  void drawBackground(sf::RenderTarget& target, const Layer& layer, Rect<float> camera);
   // parallax is a factor from 0.0 to 1.0, NOT distance!
-  void drawBackground(std::string name, Vec2f offset, Vec2f parallax_factor,
-                      bool tile_vertically = false);
-  void drawTile(Vec2f pos, TileType tile_type);
-  void drawChunk(Vec2s pos, const Tilemap::Chunk& chunk);
-  void drawTiles();
-  void drawEntities();
-  void drawWater(float height);
-  void drawHUD();
+  void drawBackground(sf::RenderTarget& target, std::string name,
+                      Vec2f offset, Vec2f parallax_factor,
+                      Rect<float> camera, bool tile_vertically = false);
+  void bakeChunk(ChunkMesh& mesh, Vec2s pos, const Tilemap::Chunk& chunk);
+  void drawTiles(sf::RenderTarget& target);
+  void drawEntities(sf::RenderTarget& target, Rect<float> camera, float alpha);
+  void drawWater(sf::RenderTarget& target, float height, Rect<float> camera);
+  void updateHUDField(std::size_t field, ULong value,
+                      const std::function<std::string()>& text,
+                      Vec2f origin, TextStyle style);
+  void drawHUD(sf::RenderTarget& target);
+
+  // position between two ticks, alpha being the fraction of a tick elapsed
+  static Vec2f interpolate(Vec2f pos_old, Vec2f pos, float alpha);
 
   static Vec2f fromScreen(Vec2f pos);
   static Vec2f toScreen(Vec2f pos);
@@ -92,13 +131,24 @@ private:
 
   bool suspended = false;
   bool suspended_previous = false;
+  bool interpolating = false;
 
   float ticktime = 0.f;
   float rendertime = 0.f;
 
-  std::optional<sf::RenderTexture> framebuffer;
-  std::optional<sf::RenderTexture> scene;
-  std::optional<sf::RenderTexture> hud;
+  RenderStats render_stats;
+  SpriteBatch sprite_batch;
+  std::vector<SpatialGrid::Item> visible_entities;
+  // sprite texture of each entity render frame, resolved the first time it is
+  // drawn; nullptr for frames without one
+  std::unordered_map<const RenderFrame*, const sf::Texture*> sprite_textures;
+  sf::VertexArray water_vertices;
+
+  std::array<HUDCache, HUDField::COUNT> hud_fields;
+
+  std::map<ChunkRef, ChunkMesh> chunk_meshes;
+  std::size_t chunk_meshes_subworld = 0;
+  std::size_t frame_count = 0;
 
   std::size_t worldnum, levelnum;
   std::size_t current_subworld = 0;
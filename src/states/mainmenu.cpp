@@ -23,11 +23,6 @@ MainMenu::Factory MainMenu::create() {
 }
 
 MainMenu::MainMenu(Engine* engine) : BaseState(nullptr, engine) {
-  if (engine->getWindow()) {
-    framebuffer.emplace();
-    framebuffer->create(480, 270);
-  }
-
   engine->music->open("title.spc");
 }
 
@@ -126,23 +121,19 @@ void MainMenu::draw(float delta) {
     if (auto& window = engine->getWindow()) {
       const auto& background = gfx.getTexture("bonusquestion");
       Vec2f bgsize = static_cast<sf::Vector2f>(background.getSize());
-      Vec2f fbsize = static_cast<sf::Vector2f>(framebuffer->getSize());
+      Vec2f fbsize = static_cast<Vec2f>(window->getCanvasSize());
 
       for (std::size_t y = 0; y < fbsize.y / bgsize.y; ++y)
       for (std::size_t x = 0; x < fbsize.x / bgsize.x; ++x) {
         sf::Sprite sprite(background);
         sprite.setPosition(x * bgsize.x, -(y * bgsize.y + bgsize.y) + fbsize.y);
-        framebuffer->draw(sprite);
+        window->draw(sprite);
       }
 
-      drawText(*framebuffer, "START GAME", Vec2f(200, 180), TextStyle("smb3_sbfont"));
-      drawText(*framebuffer, "QUIT", Vec2f(200, 188), TextStyle("smb3_sbfont"));
-
-      drawText(*framebuffer, util::highASCII(">"), Vec2f(192, 180 + entry * 8), TextStyle("smb3_sbfont"));
-
-      framebuffer->display();
+      drawText(*window, "START GAME", Vec2f(200, 180), TextStyle("smb3_sbfont"));
+      drawText(*window, "QUIT", Vec2f(200, 188), TextStyle("smb3_sbfont"));
 
-      window->getFramebuffer()->draw(sf::Sprite(framebuffer->getTexture()));
+      drawText(*window, util::highASCII(">"), Vec2f(192, 180 + entry * 8), TextStyle("smb3_sbfont"));
     }
 
     rendertime += delta;
@@ -51,7 +51,6 @@ private:
 private:
   bool paused = false;
 
-  std::optional<sf::RenderTexture> framebuffer;
 
   std::size_t entry = 0;
 
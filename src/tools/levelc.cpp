@@ -0,0 +1,90 @@
+// kme-levelc: compiles the Tiled maps in <basedir>/maps/W-L into the binary
+// <basedir>/maps/W-L.kmel files read by LevelLoader.
+//
+// usage: kme-levelc <basedir> [W-L ...]
+
+#include "../states/basegame/levelfile.hpp"
+#include "../types.hpp"
+#include "../util.hpp"
+
+#include <physfs.h>
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cstdlib>
+
+using namespace kme;
+
+static bool compileLevel(const std::string& name) {
+  StringList parts = util::split(name, "-");
+  if (parts.size() != 2) {
+    std::cerr << name << ": expected a level name of the form W-L\n";
+    return false;
+  }
+
+  try {
+    std::size_t world = std::stoul(parts[0]);
+    std::size_t level = std::stoul(parts[1]);
+
+    std::vector<char> data = LevelFile::fromJSON(world, level).toBinary();
+
+    std::string path = LevelFile::getCompiledPath(world, level);
+    PHYSFS_File* file = PHYSFS_openWrite(path.c_str());
+    if (file == nullptr) {
+      std::cerr << path << ": " << PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()) << "\n";
+      return false;
+    }
+
+    auto written = PHYSFS_writeBytes(file, data.data(), data.size());
+    PHYSFS_close(file);
+    if (written != static_cast<PHYSFS_sint64>(data.size())) {
+      std::cerr << path << ": " << PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()) << "\n";
+      return false;
+    }
+
+    std::cout << name << " -> " << path << " (" << data.size() << " bytes)\n";
+    return true;
+  }
+  catch (const std::exception& ex) {
+    std::cerr << name << ": " << ex.what() << "\n";
+    return false;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <basedir> [W-L ...]\n";
+    return EXIT_FAILURE;
+  }
+
+  if (PHYSFS_init(argv[0]) == 0
+  or PHYSFS_mount(argv[1], "/", false) == 0
+  or PHYSFS_setWriteDir(argv[1]) == 0) {
+    std::cerr << argv[1] << ": " << PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()) << "\n";
+    PHYSFS_deinit();
+    return EXIT_FAILURE;
+  }
+
+  StringList levels(argv + 2, argv + argc);
+  if (levels.empty()) {
+    // every directory under /maps is a level
+    for (const auto& entry : util::getFiles("/maps")) {
+      PHYSFS_Stat stat;
+      std::string path = "/maps/" + entry;
+      if (PHYSFS_stat(path.c_str(), &stat) != 0 and stat.filetype == PHYSFS_FILETYPE_DIRECTORY) {
+        levels.push_back(entry);
+      }
+    }
+  }
+
+  bool success = true;
+  for (const auto& name : levels) {
+    success = compileLevel(name) and success;
+  }
+
+  PHYSFS_deinit();
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,119 @@
+// All broadphases must give the same answers, in the same order, for the
+// same items. Drives each of them through the same random rebuilds, inserts,
+// moves and queries and compares every result against brute force.
+
+#include "../src/states/basegame/broadphase.hpp"
+#include "../src/states/basegame/entity.hpp"
+#include "../src/states/basegame/spatialgrid.hpp"
+#include "test.hpp"
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+using namespace kme;
+
+static bool equal(const std::vector<Broadphase::Item>& lhs, const std::vector<Broadphase::Item>& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < lhs.size(); ++i) {
+    if (lhs[i].entity != rhs[i].entity) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> coord(-50.f, 300.f);
+  std::uniform_real_distribution<float> size(0.1f, 6.f);
+  std::uniform_real_distribution<float> move(-1.5f, 1.5f);
+  auto randomAABB = [&] {
+    return Rect<float>(coord(rng), coord(rng) / 10.f, size(rng), size(rng));
+  };
+
+  const Broadphase::Type types[] = {
+    Broadphase::Type::BRUTE_FORCE, Broadphase::Type::GRID, Broadphase::Type::SWEEP_AND_PRUNE
+  };
+  const char* names[] = {"brute force", "grid", "sweep and prune"};
+  std::vector<std::unique_ptr<Broadphase>> broadphases;
+  for (auto type : types) {
+    broadphases.push_back(Broadphase::create(type));
+  }
+
+  EntityRegistry registry;
+  std::vector<Broadphase::Item> items;
+  for (std::size_t i = 0; i < 300; ++i) {
+    items.push_back(Broadphase::Item {.entity = registry.create(), .aabb = randomAABB()});
+  }
+
+  std::size_t queries = 0;
+  std::size_t mismatches[3] = {};
+  std::vector<Broadphase::Item> expected, result;
+  auto compare = [&](Rect<float> region) {
+    broadphases[0]->query(region, expected);
+    for (std::size_t i = 1; i < broadphases.size(); ++i) {
+      broadphases[i]->query(region, result);
+      mismatches[i] += not equal(expected, result);
+    }
+    ++queries;
+  };
+
+  for (std::size_t tick = 0; tick < 300; ++tick) {
+    // entities come and go between ticks, and everything moves a little
+    if (tick % 5 == 0) {
+      items.erase(items.begin() + rng() % items.size());
+    }
+    if (tick % 7 == 0) {
+      items.insert(items.begin() + rng() % items.size(),
+                   Broadphase::Item {.entity = registry.create(), .aabb = randomAABB()});
+    }
+    for (auto& item : items) {
+      item.aabb.x += move(rng);
+      item.aabb.y += move(rng);
+    }
+
+    for (auto& broadphase : broadphases) {
+      broadphase->rebuild(items);
+    }
+
+    // then individual entities move within the tick
+    for (std::size_t i = 0; i < 100; ++i) {
+      auto& item = items[rng() % items.size()];
+      item.aabb.x += 3.f * move(rng);
+      item.aabb.y += move(rng);
+      for (auto& broadphase : broadphases) {
+        broadphase->update(item.entity, item.aabb);
+      }
+      compare(item.aabb);
+      compare(Rect<float>(coord(rng), coord(rng) / 10.f, 2.f * size(rng), 2.f * size(rng)));
+    }
+  }
+
+  // filled one insert at a time instead of rebuilt
+  for (auto& broadphase : broadphases) {
+    broadphase->clear();
+    for (const auto& item : items) {
+      broadphase->insert(item.entity, item.aabb);
+    }
+    test::check(broadphase->size() == items.size(), "every inserted item is counted");
+  }
+  for (std::size_t i = 0; i < 1000; ++i) {
+    compare(Rect<float>(coord(rng), coord(rng) / 10.f, 2.f * size(rng), 2.f * size(rng)));
+  }
+
+  for (std::size_t i = 1; i < broadphases.size(); ++i) {
+    test::check(broadphases[i]->getType() == types[i], std::string(names[i]) + " reports its type");
+    test::check(mismatches[i] == 0, std::string(names[i]) + " agrees with brute force on "
+                + std::to_string(queries - mismatches[i]) + " of " + std::to_string(queries) + " queries");
+  }
+
+  std::cout << queries << " queries compared\n";
+  return test::getResult();
+}
@@ -0,0 +1,180 @@
+// Streaming a compiled level with a tiny budget: walking the focus across it
+// must page chunks in ahead of it, evict the ones it left behind farthest
+// first, and never evict a chunk that was edited after it was paged in.
+
+#include "../src/math.hpp"
+#include "../src/states/basegame/chunkstreamer.hpp"
+#include "../src/states/basegame/levelfile.hpp"
+#include "../src/states/basegame/tiledefs.hpp"
+#include "../src/states/basegame/tilemap.hpp"
+#include "../src/util.hpp"
+#include "test.hpp"
+
+#include <physfs.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdlib>
+
+using namespace kme;
+
+static constexpr std::size_t type_count = 20;
+static constexpr int chunks_wide = 10;
+static constexpr std::size_t budget = 4;
+
+// uniform, palette and dense chunks in turn
+static UInt16 getType(int x, int y) {
+  const int chunk = x / 16;
+  switch (chunk % 3) {
+  case 0:
+    return 1 + chunk % type_count;
+  case 1:
+    return 1 + (x + y) % 4;
+  default:
+    return 1 + (x + 3 * y) % type_count;
+  }
+}
+
+static std::string getTypeName(std::size_t index) {
+  std::stringstream ss;
+  ss << "Tile" << index;
+  return ss.str();
+}
+
+static bool writeLevel(const std::string& path) {
+  LevelFile level_file;
+  level_file.types.push_back("");
+  for (std::size_t i = 1; i <= type_count; ++i) {
+    level_file.types.push_back(getTypeName(i));
+  }
+
+  LevelFile::Subworld& subworld = level_file.subworlds.emplace_back();
+  subworld.id = 0;
+  subworld.bounds = Rect<int>(0, 0, chunks_wide * 16, 16);
+
+  LevelFile::Layer& layer = subworld.layers.emplace_back();
+  layer.index = 0;
+  layer.chunk_bounds = Rect<int>(0, 0, chunks_wide, 1);
+  layer.tiles.resize(chunks_wide * 256);
+  for (int chunk = 0; chunk < chunks_wide; ++chunk)
+  for (int i = 0; i < 256; ++i) {
+    layer.tiles[chunk * 256 + i] = getType(chunk * 16 + i % 16, i / 16);
+  }
+
+  std::vector<char> data = level_file.toBinary();
+  PHYSFS_File* file = PHYSFS_openWrite(path.c_str());
+  if (file == nullptr) {
+    return false;
+  }
+  auto written = PHYSFS_writeBytes(file, data.data(), data.size());
+  PHYSFS_close(file);
+  return written == static_cast<PHYSFS_sint64>(data.size());
+}
+
+// whether chunk holds the tiles of the level, except for the edited one
+static bool isPagedIn(const Tilemap& tilemap, const TileDefs& tiledefs, int chunk,
+                      Tile edited, TileID edited_tile) {
+  for (int y = 0; y < 16; ++y)
+  for (int x = chunk * 16; x < chunk * 16 + 16; ++x) {
+    const TileID expected = Tile(0, x, y) == edited
+    ? edited_tile
+    : tiledefs.getTileID(getTypeName(getType(x, y)));
+    if (tilemap.getTile(0, x, y) != expected) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool isEvicted(const Tilemap& tilemap, int chunk) {
+  for (int y = 0; y < 16; ++y)
+  for (int x = chunk * 16; x < chunk * 16 + 16; ++x) {
+    if (tilemap.getTile(0, x, y) != Tilemap::notile) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void testStreaming(const TileDefs& tiledefs, const std::string& path) {
+  std::vector<char> data = util::readFile(path);
+  LevelFile level_file = LevelFile::fromBinary(data, false);
+
+  ChunkStreamer streamer(path, level_file, 0, tiledefs, budget);
+  Tilemap tilemap(tiledefs);
+  tilemap.setBounds(level_file.subworlds[0].bounds);
+
+  // a focus in the middle of a chunk wants it and its neighbours
+  auto focusOn = [&](int chunk) {
+    streamer.update(tilemap, {Rect<float>(chunk * 16 + 8, 8, 1, 1)});
+    tilemap.clearJournal();
+  };
+
+  focusOn(0);
+  test::check(streamer.getResidentCount() == 2, "the chunks around the focus are paged in");
+
+  const Tile edited(0, 3, 5);
+  const TileID edited_tile = tiledefs.getTileID(getTypeName(type_count));
+  tilemap.setTile(edited, edited_tile);
+
+  bool paged_in = true;
+  bool within_budget = true;
+  for (int chunk = 0; chunk < chunks_wide; ++chunk) {
+    focusOn(chunk);
+    for (int wanted = std::max(chunk - 1, 0); wanted <= std::min(chunk + 1, chunks_wide - 1); ++wanted) {
+      paged_in = paged_in and isPagedIn(tilemap, tiledefs, wanted, edited, edited_tile);
+    }
+    within_budget = within_budget and streamer.getResidentCount() <= budget;
+  }
+  test::check(paged_in, "every chunk near the focus reads back as compiled");
+  test::check(within_budget, "no more chunks than the budget stay resident");
+
+  test::check(isPagedIn(tilemap, tiledefs, 0, edited, edited_tile), "the edited chunk is kept");
+  test::check(isPagedIn(tilemap, tiledefs, chunks_wide - 3, edited, edited_tile),
+              "the unwanted chunk nearest the focus is kept while within budget");
+  bool evicted = true;
+  for (int chunk = 1; chunk < chunks_wide - 3; ++chunk) {
+    evicted = evicted and isEvicted(tilemap, chunk);
+  }
+  test::check(evicted, "chunks left behind are evicted farthest first");
+
+  // walking back pages the evicted chunks in again
+  focusOn(4);
+  test::check(isPagedIn(tilemap, tiledefs, 3, edited, edited_tile)
+          and isPagedIn(tilemap, tiledefs, 5, edited, edited_tile), "evicted chunks page in again");
+  test::check(isPagedIn(tilemap, tiledefs, 0, edited, edited_tile), "the edited chunk is still kept");
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <scratch dir>\n";
+    return EXIT_FAILURE;
+  }
+
+  if (PHYSFS_init(argv[0]) == 0
+  or PHYSFS_setWriteDir(argv[1]) == 0
+  or PHYSFS_mount(argv[1], "/", false) == 0
+  or PHYSFS_mkdir("maps") == 0) {
+    std::cerr << argv[1] << ": " << PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()) << "\n";
+    PHYSFS_deinit();
+    return EXIT_FAILURE;
+  }
+
+  TileDefs tiledefs;
+  for (std::size_t i = 1; i <= type_count; ++i) {
+    tiledefs.registerTileDef(getTypeName(i), TileDef());
+  }
+
+  const std::string path = LevelFile::getCompiledPath(1, 1);
+  if (test::check(writeLevel(path), "write the test level")) {
+    testStreaming(tiledefs, path);
+  }
+
+  PHYSFS_deinit();
+  return test::getResult();
+}
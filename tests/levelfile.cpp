@@ -0,0 +1,297 @@
+// A compiled level must read back as exactly the LevelFile its Tiled maps
+// produce, and a damaged one must fail with LevelFileError instead of
+// sizing buffers from garbage counts or reading past the end.
+
+#include "../src/math.hpp"
+#include "../src/states/basegame/levelfile.hpp"
+#include "../src/util.hpp"
+#include "test.hpp"
+
+#include <json/value.h>
+#include <json/writer.h>
+
+#include <physfs.h>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdlib>
+
+using namespace kme;
+
+static bool writeFile(const std::string& path, const std::string& contents) {
+  PHYSFS_File* file = PHYSFS_openWrite(path.c_str());
+  if (file == nullptr) {
+    return false;
+  }
+  auto written = PHYSFS_writeBytes(file, contents.data(), contents.size());
+  PHYSFS_close(file);
+  return written == static_cast<PHYSFS_sint64>(contents.size());
+}
+
+static Json::Value makeProperty(const std::string& name, const std::string& value) {
+  Json::Value property;
+  property["name"] = name;
+  property["value"] = value;
+  return property;
+}
+
+// gid of the tile at x, y counting rows from the top, as Tiled stores them;
+// 0 is empty and gids 1 to 3 are tileset ids 0 to 2
+static UInt32 getGID(int layer, int x, int y) {
+  const int n = (x * 7 + y * 3 + layer) % 11;
+  return n < 4 ? n : 0;
+}
+
+static std::string makeTileData(int layer, int width, int height) {
+  std::vector<char> data;
+  for (int y = 0; y < height; ++y)
+  for (int x = 0; x < width; ++x) {
+    const UInt32 gid = getGID(layer, x, y);
+    for (int i = 0; i < 4; ++i) {
+      data.push_back(gid >> (i * 8) & 0xFF);
+    }
+  }
+  return util::base64_encode(data);
+}
+
+// a subworld that spans partial chunks, with two tile layers, entities and
+// optionally water
+static std::string makeMap(int width, int height, bool water) {
+  Json::Value root;
+  root["width"] = width;
+  root["height"] = height;
+
+  Json::Value tileset;
+  tileset["firstgid"] = 1;
+  tileset["source"] = "../tileset.json";
+  root["tilesets"].append(tileset);
+
+  root["properties"].append(makeProperty("theme", water ? "underwater" : "overworld"));
+  root["properties"].append(makeProperty("broadphase", water ? "sweep_and_prune" : ""));
+
+  for (int i = 0; i < 2; ++i) {
+    Json::Value layer;
+    layer["type"] = "tilelayer";
+    layer["data"] = makeTileData(i, width, height);
+    root["layers"].append(layer);
+  }
+
+  Json::Value objects;
+  objects["type"] = "objectgroup";
+  for (int i = 0; i < 3; ++i) {
+    Json::Value object;
+    object["gid"] = 3;
+    object["x"] = 24.f + 40.f * i;
+    object["y"] = 16.f * (height - 1) - 4.f * i;
+    object["width"] = 16.f;
+    object["height"] = 16.f;
+    objects["objects"].append(object);
+  }
+  root["layers"].append(objects);
+
+  if (water) {
+    Json::Value water_layer;
+    water_layer["type"] = "imagelayer";
+    water_layer["name"] = "Water Layer";
+    water_layer["offsety"] = 16.f * 6;
+    root["layers"].append(water_layer);
+  }
+
+  return Json::writeString(Json::StreamWriterBuilder(), root);
+}
+
+static bool writeMaps() {
+  Json::Value tileset;
+  const char* types[] = {"Ground", "Brick", "Goomba"};
+  for (int i = 0; i < 3; ++i) {
+    Json::Value tile;
+    tile["id"] = i;
+    tile["type"] = types[i];
+    tileset["tiles"].append(tile);
+  }
+
+  return PHYSFS_mkdir("maps/1-1") != 0
+  and writeFile("maps/tileset.json", Json::writeString(Json::StreamWriterBuilder(), tileset))
+  and writeFile("maps/1-1/0.json", makeMap(40, 20, true))
+  and writeFile("maps/1-1/1.json", makeMap(9, 30, false));
+}
+
+static bool isEqual(const LevelFile::Layer& lhs, const LevelFile::Layer& rhs) {
+  return lhs.index == rhs.index
+  and lhs.chunk_bounds == rhs.chunk_bounds
+  and lhs.tiles == rhs.tiles;
+}
+
+static bool isEqual(const LevelFile::Subworld& lhs, const LevelFile::Subworld& rhs) {
+  if (lhs.layers.size() != rhs.layers.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < lhs.layers.size(); ++i) {
+    if (not isEqual(lhs.layers[i], rhs.layers[i])) {
+      return false;
+    }
+  }
+  return lhs.id == rhs.id
+  and lhs.bounds == rhs.bounds
+  and lhs.theme == rhs.theme
+  and lhs.broadphase == rhs.broadphase
+  and lhs.water_height == rhs.water_height
+  and lhs.entity_types == rhs.entity_types
+  and lhs.entity_pos == rhs.entity_pos;
+}
+
+static bool isEqual(const LevelFile& lhs, const LevelFile& rhs) {
+  if (lhs.types != rhs.types or lhs.subworlds.size() != rhs.subworlds.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < lhs.subworlds.size(); ++i) {
+    if (not isEqual(lhs.subworlds[i], rhs.subworlds[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// whether data either reads back or fails with LevelFileError; anything
+// else escaping, like std::bad_alloc, is a failure
+static bool readsOrRejects(const std::vector<char>& data) {
+  try {
+    LevelFile::fromBinary(data);
+  }
+  catch (const LevelFileError&) {}
+  catch (const std::exception& ex) {
+    std::cerr << ex.what() << "\n";
+    return false;
+  }
+  return true;
+}
+
+static bool rejects(const std::vector<char>& data) {
+  try {
+    LevelFile::fromBinary(data);
+  }
+  catch (const LevelFileError&) {
+    return true;
+  }
+  catch (const std::exception& ex) {
+    std::cerr << ex.what() << "\n";
+  }
+  return false;
+}
+
+static void patchU32(std::vector<char>& data, std::size_t offset, UInt32 value) {
+  for (std::size_t i = 0; i < 4; ++i) {
+    data[offset + i] = value >> (i * 8) & 0xFF;
+  }
+}
+
+// offset of the first layer's chunk bounds width, following the layout in
+// levelfile.hpp
+static std::size_t getChunkWidthOffset(const LevelFile& level_file) {
+  std::size_t offset = 4 + 2 + 2 + 4;
+  for (const auto& type : level_file.types) {
+    offset += 2 + type.size();
+  }
+  const auto& subworld = level_file.subworlds[0];
+  offset += 4 + 4 * 4 + 2 + subworld.theme.size() + 2 + subworld.broadphase.size() + 1 + 4;
+  offset += 4 + subworld.entity_types.size() * 3 * 4;
+  offset += 4;
+  return offset + 3 * 4;
+}
+
+static void testRoundTrip(const LevelFile& from_json) {
+  test::check(from_json.subworlds.size() == 2, "both maps load as subworlds");
+  test::check(from_json.subworlds[0].water_height.has_value()
+          and not from_json.subworlds[1].water_height.has_value(), "water is read from the maps");
+
+  std::string path = LevelFile::getCompiledPath(1, 1);
+  std::vector<char> binary = from_json.toBinary();
+  if (not test::check(writeFile(path, std::string(binary.begin(), binary.end())),
+                      "write the compiled level")) {
+    return;
+  }
+
+  std::vector<char> data = util::readFile(path);
+  LevelFile compiled = LevelFile::fromBinary(data);
+  test::check(isEqual(from_json, compiled), "compiled level reads back as its maps");
+
+  LevelFile offsets_only = LevelFile::fromBinary(data, false);
+  std::vector<UInt16> tiles(256);
+  bool chunks_match = true;
+  for (std::size_t i = 0; i < compiled.subworlds.size(); ++i)
+  for (std::size_t j = 0; j < compiled.subworlds[i].layers.size(); ++j) {
+    const auto& layer = offsets_only.subworlds[i].layers[j];
+    for (std::size_t chunk = 0; chunk < layer.chunk_offsets.size(); ++chunk) {
+      LevelFile::decodeChunk(data, layer.chunk_offsets[chunk], compiled.types.size(), tiles.data());
+      const UInt16* expected = &compiled.subworlds[i].layers[j].tiles[chunk * 256];
+      chunks_match = chunks_match and std::equal(tiles.begin(), tiles.end(), expected);
+    }
+  }
+  test::check(chunks_match, "chunks decoded one at a time match the whole level");
+}
+
+static void testDamaged(const LevelFile& level_file) {
+  const std::vector<char> data = level_file.toBinary();
+
+  bool truncated = true;
+  for (std::size_t size = 0; size < data.size(); ++size) {
+    truncated = truncated and rejects(std::vector<char>(data.begin(), data.begin() + size));
+  }
+  test::check(truncated, "every truncated level file is rejected");
+
+  bool corrupt = true;
+  for (std::size_t i = 0; i < data.size(); ++i)
+  for (char value : {'\x00', '\x7F', '\xFF'}) {
+    std::vector<char> damaged = data;
+    damaged[i] = value;
+    if (not readsOrRejects(damaged)) {
+      std::cerr << "byte " << i << " set to " << +static_cast<UInt8>(value) << "\n";
+      corrupt = false;
+    }
+  }
+  test::check(corrupt, "corrupt level files only ever fail with LevelFileError");
+
+  std::vector<char> damaged = data;
+  patchU32(damaged, 8, 0xFFFFFFFF);
+  test::check(rejects(damaged), "a huge type count is rejected before reserving");
+  patchU32(damaged, 8, 0);
+  test::check(rejects(damaged), "an empty type table is rejected");
+
+  const std::size_t width = getChunkWidthOffset(level_file);
+  damaged = data;
+  patchU32(damaged, width, level_file.subworlds[0].layers[0].chunk_bounds.width);
+  test::check(damaged == data, "chunk bounds are where the layout says");
+  patchU32(damaged, width, 0x7FFFFFFF);
+  patchU32(damaged, width + 4, 0x7FFFFFFF);
+  test::check(rejects(damaged), "chunk bounds whose area overflows are rejected");
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <scratch dir>\n";
+    return EXIT_FAILURE;
+  }
+
+  if (PHYSFS_init(argv[0]) == 0
+  or PHYSFS_setWriteDir(argv[1]) == 0
+  or PHYSFS_mount(argv[1], "/", false) == 0
+  or PHYSFS_mkdir("maps") == 0) {
+    std::cerr << argv[1] << ": " << PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()) << "\n";
+    PHYSFS_deinit();
+    return EXIT_FAILURE;
+  }
+
+  if (test::check(writeMaps(), "write the test maps")) {
+    LevelFile from_json = LevelFile::fromJSON(1, 1);
+    testRoundTrip(from_json);
+    testDamaged(from_json);
+  }
+
+  PHYSFS_deinit();
+  return test::getResult();
+}
@@ -0,0 +1,118 @@
+// Loading a level must move each subworld's tilemap into the Level rather
+// than copy it. Copying allocates at least once per dense chunk, so the
+// allocations made by LevelLoader::load must not grow with the map.
+
+#include "../src/states/basegame/levelfile.hpp"
+#include "../src/states/basegame/levelloader.hpp"
+#include "../src/states/basegame/tiledefs.hpp"
+#include "../src/states/basegame/tilemap.hpp"
+#include "../src/states/basegame/world.hpp"
+#include "test.hpp"
+
+#include <physfs.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdlib>
+
+using namespace kme;
+
+static constexpr std::size_t type_count = 20;
+
+// every chunk holds more distinct tiles than fit a palette, so all are dense
+static UInt16 getType(int x, int y) {
+  return 1 + (x + 3 * y) % type_count;
+}
+
+static std::string getTypeName(std::size_t index) {
+  std::stringstream ss;
+  ss << "Tile" << index;
+  return ss.str();
+}
+
+static bool writeLevel(std::size_t level, int chunks_wide, int chunks_high) {
+  LevelFile level_file;
+  level_file.types.push_back("");
+  for (std::size_t i = 1; i <= type_count; ++i) {
+    level_file.types.push_back(getTypeName(i));
+  }
+
+  LevelFile::Subworld& subworld = level_file.subworlds.emplace_back();
+  subworld.id = 0;
+  subworld.bounds = Rect<int>(0, 0, chunks_wide * 16, chunks_high * 16);
+
+  LevelFile::Layer& layer = subworld.layers.emplace_back();
+  layer.index = 0;
+  layer.chunk_bounds = Rect<int>(0, 0, chunks_wide, chunks_high);
+  layer.tiles.resize(chunks_wide * chunks_high * 256);
+  for (int chunk = 0; chunk < chunks_wide * chunks_high; ++chunk)
+  for (int i = 0; i < 256; ++i) {
+    const int x = chunk % chunks_wide * 16 + i % 16;
+    const int y = chunk / chunks_wide * 16 + i / 16;
+    layer.tiles[chunk * 256 + i] = getType(x, y);
+  }
+
+  std::vector<char> data = level_file.toBinary();
+  std::string path = LevelFile::getCompiledPath(1, level);
+  PHYSFS_File* file = PHYSFS_openWrite(path.c_str());
+  if (file == nullptr) {
+    return false;
+  }
+  auto written = PHYSFS_writeBytes(file, data.data(), data.size());
+  PHYSFS_close(file);
+  return written == static_cast<PHYSFS_sint64>(data.size());
+}
+
+// allocations made while handing the loaded level over
+static std::size_t countLoad(const TileDefs& tiledefs, std::size_t level, Vec2i probe) {
+  LevelLoader loader(tiledefs, 1, level);
+  Level target(nullptr, nullptr);
+
+  std::size_t before = test::getAllocationCount();
+  loader.load(target);
+  std::size_t count = test::getAllocationCount() - before;
+
+  const Tilemap& tilemap = target.getSubworld(0).getTilemap();
+  test::check(tilemap.getTile(0, probe.x, probe.y) == tiledefs.getTileID(getTypeName(getType(probe.x, probe.y))),
+              "level " + std::to_string(level) + " tiles arrive in the subworld");
+  return count;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <scratch dir>\n";
+    return EXIT_FAILURE;
+  }
+
+  if (PHYSFS_init(argv[0]) == 0
+  or PHYSFS_setWriteDir(argv[1]) == 0
+  or PHYSFS_mount(argv[1], "/", false) == 0
+  or PHYSFS_mkdir("maps") == 0) {
+    std::cerr << argv[1] << ": " << PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()) << "\n";
+    PHYSFS_deinit();
+    return EXIT_FAILURE;
+  }
+
+  TileDefs tiledefs;
+  for (std::size_t i = 1; i <= type_count; ++i) {
+    tiledefs.registerTileDef(getTypeName(i), TileDef());
+  }
+
+  const std::size_t big_chunks = 16 * 8;
+  if (test::check(writeLevel(1, 2, 1) and writeLevel(2, 16, 8), "write the test levels")) {
+    std::size_t small_count = countLoad(tiledefs, 1, Vec2i(20, 5));
+    std::size_t big_count = countLoad(tiledefs, 2, Vec2i(200, 100));
+
+    std::cout << "load: " << small_count << " allocations for 2 chunks, "
+              << big_count << " for " << big_chunks << "\n";
+    test::check(big_count == small_count, "load allocations do not depend on the map size");
+    test::check(big_count < big_chunks, "load allocates less than once per chunk");
+  }
+
+  PHYSFS_deinit();
+  return test::getResult();
+}
@@ -0,0 +1,58 @@
+#include "test.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <cstddef>
+#include <cstdlib>
+
+static std::atomic<std::size_t> allocation_count = 0;
+static std::size_t failure_count = 0;
+
+void* operator new(std::size_t size) {
+  ++allocation_count;
+  if (void* ptr = std::malloc(size > 0 ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace kme::test {
+std::size_t getAllocationCount() {
+  return allocation_count;
+}
+
+bool check(bool condition, const std::string& what) {
+  if (not condition) {
+    std::cerr << "FAILED: " << what << "\n";
+    ++failure_count;
+  }
+  return condition;
+}
+
+int getResult() {
+  return failure_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+#include <cstddef>
+
+namespace kme::test {
+// calls to the global operator new since the program started
+std::size_t getAllocationCount();
+
+// reports a failed check on stderr; the test fails if any check did
+bool check(bool condition, const std::string& what);
+int getResult();
+}
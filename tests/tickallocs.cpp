@@ -0,0 +1,151 @@
+// Once a subworld has settled, ticking it must not touch the heap. Runs
+// Subworld::update over walking enemies and sliding powerups boxed in by
+// walls, so they keep landing, turning around and running into each other,
+// and counts allocations after a warmup. Repeats for every broadphase.
+
+#include "../src/states/basegame.hpp"
+#include "../src/states/basegame/broadphase.hpp"
+#include "../src/states/basegame/ecs/components.hpp"
+#include "../src/states/basegame/powerup.hpp"
+#include "../src/states/basegame/tiledefs.hpp"
+#include "../src/states/basegame/tilemap.hpp"
+#include "../src/states/basegame/world.hpp"
+#include "../src/states/gameplay.hpp"
+#include "test.hpp"
+
+#include <entt/entt.hpp>
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <cstddef>
+
+using namespace kme;
+
+static constexpr float tick_delta = 1.f / 64.f;
+// long enough for event buffers and grid cells to reach their high water
+// marks; after that, storage is only reused
+static constexpr std::size_t warmup_ticks = 64 * 64;
+static constexpr std::size_t measured_ticks = 16 * 64;
+
+static constexpr int room_width = 48;
+
+// frames for every label a state and powerup can produce
+static RenderStates makeRenderStates() {
+  RenderStates render_states;
+  for (int i = 0; i <= static_cast<int>(EState::SWIM); ++i)
+  for (int j = 0; j <= static_cast<int>(Powerup::HAMMER); ++j) {
+    std::string label(getStateName(static_cast<EState>(i)));
+    if (static_cast<Powerup>(j) != Powerup::NONE) {
+      label += ".";
+      label += getPowerupName(static_cast<Powerup>(j));
+    }
+    render_states.pushFrame(label, "sprite_0", Vec2i(0, 0), Vec2f(8, 0), 8.f / 60.f);
+    render_states.pushFrame(label, "sprite_1", Vec2i(16, 0), Vec2f(8, 0), 8.f / 60.f);
+  }
+  return render_states;
+}
+
+static void setupBaseGame(BaseGame& basegame) {
+  basegame.level_tile_data.registerTileDef("Ground", TileDef());
+
+  basegame.entity_spawn_data["Goomba"] = [](EntityRegistry& entities, Entity entity) {
+    entities.emplace<CFlags>(entity, EFlags::ENEMY | EFlags::NOFRICTION);
+    entities.emplace<CState>(entity, EState::WALK);
+    entities.emplace<CVelocity>(entity, Vec2f(-2.f, 0.f));
+    entities.emplace<CCollision>(entity, Hitbox(0.5f, 0.75f));
+    entities.emplace<CDirection>(entity);
+    entities.emplace<CTimers>(entity);
+    entities.emplace<CRender>(entity);
+  };
+  basegame.entity_spawn_data["Mushroom"] = [](EntityRegistry& entities, Entity entity) {
+    entities.emplace<CFlags>(entity, EFlags::POWERUP | EFlags::NOFRICTION);
+    entities.emplace<CVelocity>(entity, Vec2f(4.f, 0.f));
+    entities.emplace<CCollision>(entity, Hitbox(0.5f, 1.f));
+    entities.emplace<CPowerup>(entity, Powerup::MUSHROOM);
+    entities.emplace<CDirection>(entity);
+    entities.emplace<CState>(entity);
+    entities.emplace<CRender>(entity);
+  };
+
+  basegame.entity_data.registerRenderStates("Goomba", makeRenderStates());
+  basegame.entity_data.registerRenderStates("Mushroom", makeRenderStates());
+}
+
+// a floor with a wall at each end, and a row of entities dropped onto it
+static void setupSubworld(Subworld& subworld, const TileDefs& tiledefs) {
+  const TileID ground = tiledefs.getTileID("Ground");
+  Tilemap tilemap;
+  tilemap.setTileDefs(tiledefs);
+  tilemap.setBounds(Rect<int>(0, 0, room_width, 16));
+  for (int x = 0; x < room_width; ++x) {
+    tilemap.setTile(0, x, 0, ground);
+  }
+  for (int y = 1; y < 4; ++y) {
+    tilemap.setTile(0, 0, y, ground);
+    tilemap.setTile(0, room_width - 1, y, ground);
+  }
+  tilemap.clearJournal();
+  tilemap.clearDirtyChunks();
+
+  EntityData entity_data;
+  for (int x = 2; x < room_width - 2; x += 3) {
+    entity_data.types.push_back(x % 2 ? "Mushroom" : "Goomba");
+    entity_data.pos.push_back(Vec2f(x + 0.5f, 1.f + x % 3));
+  }
+
+  subworld.setBounds(0, 0, room_width, 16);
+  subworld.setTilemap(std::move(tilemap));
+  subworld.setEntities(std::move(entity_data));
+  subworld.player = entt::null;
+  subworld.camera = entt::null;
+  subworld.loadEntities();
+}
+
+static void runTicks(BaseGame& basegame, Gameplay& gameplay, Broadphase::Type type,
+                     const std::string& name) {
+  Subworld subworld(&basegame, &gameplay);
+  subworld.setBroadphaseType(type);
+  setupSubworld(subworld, basegame.level_tile_data);
+
+  for (std::size_t i = 0; i < warmup_ticks; ++i) {
+    subworld.update(tick_delta);
+  }
+
+  std::size_t before = test::getAllocationCount();
+  for (std::size_t i = 0; i < measured_ticks; ++i) {
+    subworld.update(tick_delta);
+  }
+  std::size_t allocations = test::getAllocationCount() - before;
+
+  // make sure the ticks did collide: something has turned around
+  std::size_t turned = 0;
+  auto view = subworld.getEntities().view<CVelocity, CFlags>();
+  for (auto entity : view) {
+    const auto& flags = view.get<CFlags>(entity).value;
+    const auto& vel = view.get<CVelocity>(entity).value;
+    turned += (flags & EFlags::ENEMY) ? vel.x > 0.f : vel.x < 0.f;
+  }
+
+  std::cout << name << ": " << allocations << " allocations over "
+            << measured_ticks << " ticks\n";
+  test::check(turned > 0, name + ": entities collide with walls and each other");
+  test::check(allocations == 0, name + ": ticks do not allocate once warmed up");
+}
+
+int main() {
+  std::unique_ptr<BaseState> basegame_state(BaseGame::create()(nullptr, nullptr));
+  auto& basegame = static_cast<BaseGame&>(*basegame_state);
+  setupBaseGame(basegame);
+
+  // no engine: nothing in these ticks plays sound or reads the window
+  std::unique_ptr<BaseState> gameplay_state(Gameplay::create(1, 1)(basegame_state.get(), nullptr));
+  auto& gameplay = static_cast<Gameplay&>(*gameplay_state);
+
+  runTicks(basegame, gameplay, Broadphase::Type::BRUTE_FORCE, "brute force");
+  runTicks(basegame, gameplay, Broadphase::Type::GRID, "grid");
+  runTicks(basegame, gameplay, Broadphase::Type::SWEEP_AND_PRUNE, "sweep and prune");
+
+  return test::getResult();
+}
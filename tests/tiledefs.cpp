@@ -0,0 +1,84 @@
+// The per-frame table filled by TileDefs::updateFrames must pick the same
+// frame for every tile as RenderFrames::getFrameOffset would at that time.
+
+#include "../src/math.hpp"
+#include "../src/renderstates.hpp"
+#include "../src/states/basegame/tiledefs.hpp"
+#include "test.hpp"
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+using namespace kme;
+
+struct Animation {
+  TileID tile_id;
+  RenderFrames frames;
+};
+
+static Animation registerAnimation(TileDefs& tiledefs, const std::string& name,
+                                   const std::vector<float>& durations) {
+  Animation animation;
+  TileDef tiledef;
+  for (std::size_t i = 0; i < durations.size(); ++i) {
+    const Vec2i origin(16 * i, 0);
+    tiledef.pushFrame(name, origin, durations[i]);
+    animation.frames.pushFrame(name, Rect<int>(origin, Vec2i(16, 16)), Vec2f(), durations[i]);
+  }
+  animation.tile_id = tiledefs.registerTileDef(name, tiledef);
+  return animation;
+}
+
+static bool matches(const TileDefs& tiledefs, const Animation& animation, float time) {
+  const std::size_t offset = animation.frames.getFrameOffset(time);
+  const RenderFrame& frame = tiledefs.getCurrentFrame(animation.tile_id);
+  return tiledefs.getFrameOffset(animation.tile_id) == offset
+  and &frame == &tiledefs.getTileDef(animation.tile_id).getFrame(offset)
+  and frame.cliprect == animation.frames.getFrame(offset).cliprect;
+}
+
+int main() {
+  TileDefs tiledefs;
+  std::vector<Animation> animations = {
+    registerAnimation(tiledefs, "Still", {0.f}),
+    registerAnimation(tiledefs, "Timed", {0.5f}),
+    registerAnimation(tiledefs, "Even", {0.125f, 0.125f, 0.125f, 0.125f}),
+    registerAnimation(tiledefs, "Uneven", {0.1f, 0.3f, 0.05f}),
+    registerAnimation(tiledefs, "Zero", {0.f, 0.f})
+  };
+
+  // every 60th of a second, plus the exact frame boundaries
+  std::vector<float> times;
+  for (int i = 0; i < 600; ++i) {
+    times.push_back(i / 60.f);
+  }
+  for (float time : {0.1f, 0.4f, 0.45f, 0.5f, 0.55f, 1.f, 123.456f}) {
+    times.push_back(time);
+  }
+
+  bool match = true;
+  bool animated = false;
+  for (float time : times) {
+    tiledefs.updateFrames(time);
+    for (const auto& animation : animations) {
+      match = match and matches(tiledefs, animation, time);
+    }
+    animated = animated or tiledefs.getFrameOffset(animations[3].tile_id) == 2;
+  }
+  test::check(match, "the frame table matches RenderFrames for animated and single-frame tiles");
+  test::check(animated, "animated tiles move on through their frames");
+
+  test::check(tiledefs.getFrameOffset(0) == 0
+          and &tiledefs.getCurrentFrame(0) == &tiledefs.getTileDef(0).getFrame(0),
+              "the default tile stays on its only frame");
+
+  // tiles registered after an update start out on their first frame
+  Animation late = registerAnimation(tiledefs, "Late", {0.25f, 0.25f});
+  test::check(tiledefs.getFrameOffset(late.tile_id) == 0, "a new tile starts on its first frame");
+  tiledefs.updateFrames(0.3f);
+  test::check(matches(tiledefs, late, 0.3f), "a new tile is animated by the next update");
+
+  return test::getResult();
+}
@@ -0,0 +1,328 @@
+// Tilemap bookkeeping: every setTile that changes the map must show up in
+// the journal and mark its chunk dirty exactly once until drained. Chunks
+// must read back the same whichever storage they are promoted or compacted
+// into, and spans must agree with getTile over any range.
+
+#include "../src/math.hpp"
+#include "../src/states/basegame/tiledefs.hpp"
+#include "../src/states/basegame/tilemap.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <cstddef>
+
+using namespace kme;
+
+struct Tiles {
+  TileDefs tiledefs;
+  TileID ground;
+  TileID water;
+};
+
+static void setupTiles(Tiles& tiles) {
+  TileDef ground;
+  ground.setCollisionType(TileDef::CollisionType::SOLID);
+  tiles.ground = tiles.tiledefs.registerTileDef("Ground", ground);
+
+  TileDef water;
+  water.setCollisionType(TileDef::CollisionType::WATER);
+  tiles.water = tiles.tiledefs.registerTileDef("Water", water);
+}
+
+static std::vector<ChunkRef> drain(Tilemap& tilemap) {
+  std::vector<ChunkRef> result;
+  tilemap.drainDirtyChunks([&](const ChunkRef& ref) {
+    result.push_back(ref);
+  });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+using Entry = Tilemap::Chunk::Entry;
+using Storage = Tilemap::Chunk::Storage;
+
+// entries that differ in their tile, their collision type or both
+static Entry makeEntry(std::size_t n) {
+  return Entry {
+    .tile = static_cast<TileID>(n / 2),
+    .collision = n % 2 == 0 ? TileDef::CollisionType::NONE : TileDef::CollisionType::SOLID
+  };
+}
+
+// a chunk and the plain array it should always read back as
+struct ChunkModel {
+  Tilemap::Chunk chunk;
+  std::array<Entry, 256> cells;
+
+  ChunkModel(Entry uniform) : chunk(uniform) {
+    cells.fill(uniform);
+  }
+
+  void set(std::size_t x, std::size_t y, Entry entry) {
+    const bool changed = cells[y * 16 + x] != entry;
+    cells[y * 16 + x] = entry;
+    if (chunk.setEntry(x, y, entry) != changed) {
+      test::check(false, "setEntry reports whether the cell changed");
+    }
+  }
+
+  bool matches() const {
+    for (std::size_t y = 0; y < 16; ++y)
+    for (std::size_t x = 0; x < 16; ++x) {
+      const Entry& cell = cells[y * 16 + x];
+      if (chunk.getEntry(x, y) != cell
+      or  chunk.getTile(x, y) != cell.tile
+      or  chunk.getCollisionType(x, y) != cell.collision) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+static void testStorage() {
+  const std::size_t allocations = test::getAllocationCount();
+  ChunkModel model(makeEntry(0));
+  Tilemap::Chunk copy = model.chunk;
+  const bool allocated = test::getAllocationCount() != allocations;
+  test::check(not allocated, "uniform chunks do not allocate");
+  test::check(copy.isUniform() and model.matches(), "a new chunk is uniform");
+
+  model.set(3, 0, makeEntry(1));
+  test::check(model.chunk.getStorage() == Storage::PALETTE and model.matches(),
+              "a second distinct entry promotes a uniform chunk to a palette");
+  test::check(model.chunk.getTileRow(0) == nullptr, "palette chunks have no dense rows");
+
+  for (std::size_t n = 2; n < Tilemap::Chunk::PALETTE_MAX; ++n) {
+    model.set(n, n, makeEntry(n));
+  }
+  model.set(15, 14, makeEntry(1));
+  test::check(model.chunk.getStorage() == Storage::PALETTE and model.matches(),
+              "a full palette still holds every entry");
+
+  model.set(7, 9, makeEntry(Tilemap::Chunk::PALETTE_MAX));
+  test::check(model.chunk.getStorage() == Storage::DENSE and model.matches(),
+              "one entry more than the palette holds promotes the chunk to dense");
+  test::check(model.chunk.getTileRow(9)[7] == makeEntry(Tilemap::Chunk::PALETTE_MAX).tile
+          and model.chunk.getCollisionRow(9)[7] == makeEntry(Tilemap::Chunk::PALETTE_MAX).collision,
+              "dense rows hold both planes");
+
+  model.chunk.compact();
+  test::check(model.chunk.getStorage() == Storage::DENSE and model.matches(),
+              "compact leaves a chunk with too many entries dense");
+
+  model.set(7, 9, makeEntry(0));
+  model.set(2, 2, makeEntry(0));
+  model.chunk.compact();
+  test::check(model.chunk.getStorage() == Storage::PALETTE and model.matches(),
+              "compact packs a dense chunk back into a palette");
+
+  // the palette dropped the unused entry, so there is room for a new one
+  model.set(4, 11, makeEntry(Tilemap::Chunk::PALETTE_MAX + 1));
+  test::check(model.chunk.getStorage() == Storage::PALETTE and model.matches(),
+              "compact drops palette entries no longer in use");
+
+  for (std::size_t y = 0; y < 16; ++y)
+  for (std::size_t x = 0; x < 16; ++x) {
+    model.set(x, y, makeEntry(5));
+  }
+  model.chunk.compact();
+  test::check(model.chunk.isUniform() and model.chunk.getUniform() == makeEntry(5) and model.matches(),
+              "compact turns a chunk with a single entry uniform");
+}
+
+static void testCollisionSync(const Tiles& tiles) {
+  Tilemap tilemap(tiles.tiledefs);
+
+  bool in_sync = true;
+  auto checkCell = [&](int x, int y, TileID tile, TileDef::CollisionType collision) {
+    in_sync = in_sync
+    and tilemap.getTile(0, x, y) == tile
+    and tilemap.getCollisionType(0, x, y) == collision;
+  };
+
+  // through a palette chunk and compacted back
+  tilemap.setTile(0, 1, 1, tiles.ground);
+  checkCell(1, 1, tiles.ground, TileDef::CollisionType::SOLID);
+  checkCell(2, 1, Tilemap::notile, TileDef::CollisionType::NONE);
+
+  tilemap.setTile(0, 1, 1, tiles.water);
+  checkCell(1, 1, tiles.water, TileDef::CollisionType::WATER);
+
+  for (int i = 0; i < 16; ++i) {
+    tilemap.setTile(0, i, 5, i % 2 == 0 ? tiles.ground : tiles.water);
+  }
+  tilemap.compact();
+  for (int i = 0; i < 16; ++i) {
+    checkCell(i, 5, i % 2 == 0 ? tiles.ground : tiles.water,
+              i % 2 == 0 ? TileDef::CollisionType::SOLID : TileDef::CollisionType::WATER);
+  }
+  tilemap.setTile(0, 1, 1, Tilemap::notile);
+  checkCell(1, 1, Tilemap::notile, TileDef::CollisionType::NONE);
+
+  test::check(in_sync, "setTile keeps the collision plane in sync with the tiles");
+}
+
+// chunks of every storage around the origin, so ranges cross into negative
+// coordinates; chunk (1, 0) is left missing
+static void fillSpanChunks(Tilemap& tilemap) {
+  tilemap.setChunk(0, Vec2s(-1, -1), Tilemap::Chunk(makeEntry(3)));
+
+  Tilemap::Chunk palette(makeEntry(0));
+  Tilemap::Chunk dense(makeEntry(0));
+  for (std::size_t y = 0; y < 16; ++y)
+  for (std::size_t x = 0; x < 16; ++x) {
+    palette.setEntry(x, y, makeEntry((x * 3 + y) % 5));
+    dense.setEntry(x, y, makeEntry(x + y * 2));
+  }
+  tilemap.setChunk(0, Vec2s(0, -1), palette);
+  tilemap.setChunk(0, Vec2s(-1, 0), dense);
+
+  // a dense chunk packed back into a palette by compact()
+  Tilemap::Chunk compacted = palette;
+  for (std::size_t x = 0; x < 16; ++x) {
+    compacted.setEntry(x, 7, makeEntry(x + 20));
+  }
+  for (std::size_t x = 0; x < 16; ++x) {
+    compacted.setEntry(x, 7, makeEntry(x % 9));
+  }
+  compacted.compact();
+  tilemap.setChunk(0, Vec2s(0, 0), compacted);
+  tilemap.setChunk(1, Vec2s(0, 0), palette);
+
+  test::check(tilemap.getChunks(0).at(Vec2s(-1, -1)).getStorage() == Storage::UNIFORM
+          and tilemap.getChunks(0).at(Vec2s(0, -1)).getStorage() == Storage::PALETTE
+          and tilemap.getChunks(0).at(Vec2s(-1, 0)).getStorage() == Storage::DENSE
+          and tilemap.getChunks(0).at(Vec2s(0, 0)).getStorage() == Storage::PALETTE,
+              "span test chunks use every storage");
+}
+
+// every tile visited by forEachSpan must match getTile and getCollisionType,
+// and every tile of range in an existing chunk must be visited exactly once
+static bool spansMatch(const Tilemap& tilemap, int layer, Rect<int> range) {
+  std::vector<int> visits(std::max(range.width, 0) * std::max(range.height, 0));
+  bool match = true;
+  tilemap.forEachSpan(layer, range, [&](const Tilemap::Span& span) {
+    for (std::size_t i = 0; i < span.length; ++i) {
+      const int x = span.pos.x + i;
+      const int y = span.pos.y;
+      if (x < range.x or x >= range.x + range.width or y < range.y or y >= range.y + range.height) {
+        match = false;
+        continue;
+      }
+      ++visits[(y - range.y) * range.width + (x - range.x)];
+      match = match
+      and span.layer == layer
+      and span.getTile(i) == tilemap.getTile(layer, x, y)
+      and span.getCollisionType(i) == tilemap.getCollisionType(layer, x, y)
+      and (not span.isUniform() or span.getTile(i) == span.uniform.tile);
+    }
+  });
+
+  for (int y = range.y; y < range.y + range.height; ++y)
+  for (int x = range.x; x < range.x + range.width; ++x) {
+    const bool exists = tilemap.getChunks(layer).find(Tilemap::getChunkPos(x, y)) != nullptr;
+    match = match and visits[(y - range.y) * range.width + (x - range.x)] == (exists ? 1 : 0);
+  }
+  return match;
+}
+
+static void testSpans(bool bounded) {
+  Tilemap tilemap;
+  if (bounded) {
+    // the negative chunks land in the overflow map
+    tilemap.setBounds(Rect<int>(0, 0, 32, 16));
+  }
+  fillSpanChunks(tilemap);
+
+  const std::vector<Rect<int>> ranges = {
+    Rect<int>(-16, -16, 32, 32),
+    Rect<int>(-5, -3, 13, 9),
+    Rect<int>(-20, -20, 60, 40),
+    Rect<int>(-16, 0, 16, 16),
+    Rect<int>(3, -7, 1, 1),
+    Rect<int>(-1, -16, 1, 32),
+    Rect<int>(-7, 15, 30, 1),
+    Rect<int>(-4, -4, 0, 8)
+  };
+
+  bool match = true;
+  for (const auto& range : ranges) {
+    match = match and spansMatch(tilemap, 0, range) and spansMatch(tilemap, 1, range);
+  }
+  test::check(match, bounded
+  ? "spans match getTile across grid and overflow chunks"
+  : "spans match getTile across uniform, palette and dense chunks");
+
+  std::size_t layer1_tiles = 0;
+  tilemap.forEachSpan(Rect<int>(-5, -3, 13, 9), [&](const Tilemap::Span& span) {
+    if (span.layer == 1) {
+      layer1_tiles += span.length;
+    }
+  });
+  test::check(layer1_tiles == 8 * 6, "spans over every layer include each layer's chunks");
+}
+
+static void testJournal(const Tiles& tiles) {
+  Tilemap tilemap(tiles.tiledefs);
+  tilemap.setBounds(Rect<int>(0, 0, 64, 32));
+
+  tilemap.setTile(0, 3, 4, tiles.ground);
+  tilemap.setTile(0, 3, 4, tiles.water);
+  tilemap.setTile(0, 5, 4, tiles.ground);
+  tilemap.setTile(0, 5, 4, tiles.ground);
+  tilemap.setTile(1, 40, 20, tiles.ground);
+  tilemap.setTile(0, -3, -1, tiles.water);
+
+  const auto& journal = tilemap.getJournal();
+  test::check(journal.size() == 5, "setTile journals changes and skips rewrites of the same tile");
+  test::check(journal.size() >= 2
+          and journal[0].tile == Tile(0, 3, 4)
+          and journal[0].old_tile == Tilemap::notile and journal[0].new_tile == tiles.ground
+          and journal[1].old_tile == tiles.ground and journal[1].new_tile == tiles.water,
+              "journal entries hold the tile and its old and new ids in order");
+
+  const std::vector<ChunkRef> expected = [] {
+    std::vector<ChunkRef> refs = {
+      ChunkRef {0, Vec2s(0, 0)},
+      ChunkRef {1, Vec2s(2, 1)},
+      ChunkRef {0, Vec2s(-1, -1)}
+    };
+    std::sort(refs.begin(), refs.end());
+    return refs;
+  }();
+  test::check(tilemap.getDirtyChunks().size() == 3, "each changed chunk is dirty once");
+  test::check(drain(tilemap) == expected, "draining visits every changed chunk, in or out of bounds");
+  test::check(tilemap.getDirtyChunks().empty(), "draining forgets the dirty chunks");
+
+  tilemap.setTile(0, 3, 4, tiles.water);
+  test::check(tilemap.getDirtyChunks().empty(), "a rewrite of the same tile dirties nothing");
+  tilemap.setTile(0, 3, 4, tiles.ground);
+  test::check(tilemap.getDirtyChunks().size() == 1, "a drained chunk is dirtied again by the next change");
+
+  tilemap.clearJournal();
+  test::check(tilemap.getJournal().empty(), "clearJournal empties the journal");
+
+  tilemap.clearDirtyChunks();
+  tilemap.setChunk(0, Vec2s(1, 1), Tilemap::Chunk());
+  tilemap.resetChunk(0, Vec2s(0, 0));
+  test::check(tilemap.getJournal().empty(), "whole-chunk replacement does not go through the journal");
+  test::check(drain(tilemap).size() == 2, "whole-chunk replacement marks chunks dirty");
+  test::check(tilemap.getTile(0, 3, 4) == Tilemap::notile, "resetChunk empties a grid chunk");
+}
+
+int main() {
+  Tiles tiles;
+  setupTiles(tiles);
+
+  testJournal(tiles);
+  testStorage();
+  testCollisionSync(tiles);
+  testSpans(false);
+  testSpans(true);
+
+  return test::getResult();
+}